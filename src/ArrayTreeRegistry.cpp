@@ -0,0 +1,27 @@
+#include "TreeRegistry.h"
+
+// headers the tree headers include, pulled in first so their include guards
+// keep them out of the namespace below
+#include "GeneralizedZipTree.h"
+#include "UniformOpenSSLRandom.h"
+
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace array_trees
+{
+#include "ZipTree2.h"
+#include "UniformZipTree2.h"
+#include "ZipZipTree2.h"
+// DynamicZipTree3.h is identical to DynamicZipTree2.h
+#include "DynamicZipTree2.h"
+}
+
+void register_array_trees(TreeRegistry& registry)
+{
+	registry["original2"] = {[](const TreeParameters& parameters) { return std::make_unique<array_trees::ZipTree<unsigned>>(parameters.maxSize); }};
+	registry["uniform2"] = {[](const TreeParameters& parameters) { return std::make_unique<array_trees::UniformZipTree<unsigned>>(parameters.maxSize); }};
+	registry["zipzip2"] = {[](const TreeParameters& parameters) { return std::make_unique<array_trees::ZipZipTree<unsigned>>(parameters.maxSize); }};
+	registry["dynamic"] = {[](const TreeParameters& parameters) { return std::make_unique<array_trees::DynamicZipTree<unsigned>>(parameters.maxSize); }};
+}
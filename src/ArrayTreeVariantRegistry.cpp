@@ -0,0 +1,21 @@
+#include "TreeRegistry.h"
+
+// headers the tree headers include, pulled in first so their include guards
+// keep them out of the namespace below
+#include "GeneralizedZipTree.h"
+#include "UniformOpenSSLRandom.h"
+
+#include <random>
+
+// these share include guards with ZipTree2.h and ZipZipTree2.h
+namespace array_tree_variants
+{
+#include "ZipTreeVariableP.h"
+#include "ZipZipTree3.h"
+}
+
+void register_array_tree_variants(TreeRegistry& registry)
+{
+	registry["variable-p"] = {[](const TreeParameters& parameters) { return std::make_unique<array_tree_variants::ZipTreeVariableP<unsigned>>(parameters.maxSize, parameters.p); }, true};
+	registry["zipzip3"] = {[](const TreeParameters& parameters) { return std::make_unique<array_tree_variants::ZipZipTree<unsigned>>(parameters.maxSize); }};
+}
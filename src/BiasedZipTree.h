@@ -0,0 +1,279 @@
+#ifndef BIASEDZIPTREE_H
+#define BIASEDZIPTREE_H
+
+#include "GeneralizedZipTree.h"
+
+#include "UniformOpenSSLRandom.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+/**
+ * @param  weight weight of a node; weights below 1 count as 1
+ * @return        floor(log2(weight)), the part of a biased rank that the
+ *                weight decides
+ */
+inline uint8_t get_weight_level(uint64_t weight) noexcept
+{
+	return weight > 1 ? std::bit_width(weight) - 1 : 0;
+}
+
+struct BiasedRank
+{
+	// get_weight_level(weight) plus the geometric part, capped at 255
+	uint8_t rank;
+	// kept apart from rank, which the cap may have cut short
+	uint8_t geometric;
+	uint64_t weight;
+	uint64_t* totalComparisons;
+	uint64_t* firstTies;
+
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return rank;
+	}
+
+	/**
+	 * @return the geometric part of the rank, which is kept when the weight
+	 *         changes
+	 */
+	uint8_t getGeometric() const noexcept
+	{
+		return geometric;
+	}
+
+	inline int updateComparisons(const BiasedRank& other) const noexcept
+	{
+		++(*totalComparisons);
+		if (rank == other.rank)
+		{
+			++(*firstTies);
+			return 0;
+		}
+
+		return rank < other.rank ? -1 : 1;
+	}
+
+	bool operator<(const BiasedRank& other) const noexcept
+	{
+		return updateComparisons(other) < 0;
+	}
+
+	bool operator>(const BiasedRank& other) const noexcept
+	{
+		return updateComparisons(other) > 0;
+	}
+
+	bool operator==(const BiasedRank& other) const noexcept
+	{
+		return updateComparisons(other) == 0;
+	}
+
+	bool operator<=(const BiasedRank& other) const noexcept
+	{
+		return updateComparisons(other) <= 0;
+	}
+
+	bool operator>=(const BiasedRank& other) const noexcept
+	{
+		return updateComparisons(other) >= 0;
+	}
+};
+
+/**
+ * Biased zip tree: a node of weight w gets rank floor(log2(w)) + g, where g
+ * is geometric(1/2) as in a plain zip tree, so a node's expected depth is
+ * O(log(W / w)) for a total weight W and heavy keys sit near the root.
+ *
+ * Weights are either given explicitly or counted by access, which adds one to
+ * a key's weight per lookup. Changing a weight keeps the geometric part of
+ * the rank, and only when the level floor(log2(w)) changes is the node zipped
+ * out and unzipped back in at its new rank, so counting accesses restructures
+ * the tree once every time a key's count doubles.
+ *
+ * Keys inserted without a weight have weight 1, in which case the tree is
+ * distributed exactly like ZipTree.
+ */
+template <typename KeyType, typename Compare = std::less<KeyType>>
+class BiasedZipTree : public GeneralizedZipTree<KeyType, BiasedRank, Compare>
+{
+	typedef GeneralizedZipTree<KeyType, BiasedRank, Compare> Base;
+
+public:
+	BiasedZipTree(unsigned maxSize, const Compare& compare = Compare()) : Base(maxSize, compare) {}
+
+	void insert(const KeyType& key) noexcept
+	{
+		Base::insert(key);
+	}
+
+	/**
+	 * Inserts a key with a rank drawn earlier by sampleRank, whose weight may
+	 * have been set since. The rank is recomputed from its geometric part and
+	 * weight, so it always agrees with the weight.
+	 *
+	 * @param key  key of node to insert
+	 * @param rank rank of the node
+	 */
+	void insert(const KeyType& key, BiasedRank rank) noexcept
+	{
+		setRankWeight(rank, rank.getGeometric(), rank.weight);
+		Base::insert(key, rank);
+	}
+
+	void fingerInsert(const KeyType& key) noexcept
+	{
+		Base::fingerInsert(key);
+	}
+
+	/**
+	 * As insert with a rank, but starting from the right spine.
+	 */
+	void fingerInsert(const KeyType& key, BiasedRank rank) noexcept
+	{
+		setRankWeight(rank, rank.getGeometric(), rank.weight);
+		Base::fingerInsert(key, rank);
+	}
+
+	/**
+	 * Inserts a key with a given weight. As with insert, the key must not
+	 * already exist.
+	 *
+	 * @param key    key of node to insert
+	 * @param weight weight of the node, at least 1
+	 */
+	void insert(const KeyType& key, uint64_t weight) noexcept
+	{
+		BiasedRank rank = this->sampleRank();
+		setRankWeight(rank, rank.getGeometric(), weight);
+		Base::insert(key, rank);
+	}
+
+	/**
+	 * @param  key key to look up
+	 * @return     weight of the node with that key, or 0 if there is none
+	 */
+	uint64_t getWeight(const KeyType& key) const noexcept
+	{
+		unsigned index = findIndex(key);
+		return index != Base::NULLPTR ? this->_buckets[index].rank.weight : 0;
+	}
+
+	/**
+	 * Changes the weight of a key, moving its node to the level of its new
+	 * rank if that changed.
+	 *
+	 * @param  key    key whose weight to change
+	 * @param  weight new weight, at least 1
+	 * @return        true if the key was found, false otherwise
+	 */
+	bool setWeight(const KeyType& key, uint64_t weight) noexcept
+	{
+		unsigned index = findIndex(key);
+		if (index == Base::NULLPTR)
+		{
+			return false;
+		}
+
+		reweigh(index, weight);
+		return true;
+	}
+
+	/**
+	 * Looks up a key and adds one to its weight.
+	 *
+	 * @param  key key to look up
+	 * @return     true if the key was found, false otherwise
+	 */
+	bool access(const KeyType& key) noexcept
+	{
+		unsigned index = findIndex(key);
+		if (index == Base::NULLPTR)
+		{
+			return false;
+		}
+
+		uint64_t weight = this->_buckets[index].rank.weight;
+		if (weight != std::numeric_limits<uint64_t>::max())
+		{
+			reweigh(index, weight + 1);
+		}
+
+		return true;
+	}
+
+protected:
+	BiasedRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
+	{
+		uint8_t geometric = get_random_geometric();
+		return {geometric, geometric, 1, totalComparisons, firstTies};
+	}
+
+	/**
+	 * Keeps the weight of a node and only redraws the geometric part of its
+	 * rank.
+	 */
+	BiasedRank redrawRank(const BiasedRank& rank) noexcept override
+	{
+		BiasedRank newRank = this->sampleRank();
+		setRankWeight(newRank, newRank.getGeometric(), rank.weight);
+		return newRank;
+	}
+
+private:
+	/**
+	 * @return index of the bucket with a given key, or NULLPTR
+	 */
+	unsigned findIndex(const KeyType& key) const noexcept
+	{
+		unsigned curIndex = this->_buckets.empty() ? Base::NULLPTR : this->_rootIndex;
+		while (curIndex != Base::NULLPTR)
+		{
+			const auto& cur = this->_buckets[curIndex];
+			if (this->_compare(key, cur.key))
+			{
+				curIndex = cur.left;
+			}
+			else if (this->_compare(cur.key, key))
+			{
+				curIndex = cur.right;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		return curIndex;
+	}
+
+	static void setRankWeight(BiasedRank& rank, uint8_t geometric, uint64_t weight) noexcept
+	{
+		rank.geometric = geometric;
+		rank.weight = std::max<uint64_t>(weight, 1);
+		rank.rank = std::min<unsigned>(get_weight_level(rank.weight) + geometric, std::numeric_limits<uint8_t>::max());
+	}
+
+	void reweigh(unsigned index, uint64_t weight) noexcept
+	{
+		BiasedRank rank = this->_buckets[index].rank;
+		uint8_t oldRank = rank.rank;
+		setRankWeight(rank, rank.getGeometric(), weight);
+
+		if (rank.rank == oldRank)
+		{
+			this->_buckets[index].rank.weight = rank.weight;
+			return;
+		}
+
+		// zip the node out and unzip it back in at its new rank
+		KeyType key = this->_buckets[index].key;
+		this->remove(key);
+		Base::insert(key, rank);
+	}
+};
+
+#endif
@@ -1,8 +1,16 @@
 #ifndef BINARYSEARCHTREE_H
 #define BINARYSEARCHTREE_H
 
+#include "DepthProfile.h"
+#include "MemoryUsage.h"
+#include "StructuralCounters.h"
+#include "TreeStatistics.h"
+
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 template <typename KeyType>
 class BinarySearchTree
@@ -13,15 +21,61 @@ public:
 	virtual ~BinarySearchTree() = default;
 
 	virtual void insert(const KeyType& key) noexcept = 0;
-	// virtual bool remove(const KeyType& key) noexcept = 0;
+	virtual bool remove(const KeyType& key) noexcept = 0;
 	virtual int getDepth(const KeyType& key) const noexcept = 0;
 	virtual int getHeight() const noexcept = 0;
 	virtual double getAverageHeight() const noexcept = 0;
 	virtual unsigned getSize() const noexcept = 0;
 	virtual bool find(const KeyType& key) const noexcept = 0;
+
+	/**
+	 * Counts the keys in [low, high], only visiting the nodes on the paths to
+	 * both bounds and the nodes in between.
+	 *
+	 * @param  low  smallest key to count
+	 * @param  high largest key to count
+	 * @return      number of keys in the range
+	 */
+	virtual unsigned countRange(const KeyType& low, const KeyType& high) const noexcept = 0;
+
 	virtual uint64_t getTotalComparisons() const noexcept = 0;
 	virtual uint64_t getFirstTies() const noexcept = 0;
 	virtual uint64_t getBothTies() const noexcept = 0;
+
+	/**
+	 * Gathers height, depth and rank statistics in a single traversal.
+	 *
+	 * @param  pool thread pool to split the traversal across, or nullptr;
+	 *              ignored when called from one of its own workers
+	 * @return      statistics of the whole tree
+	 */
+	virtual TreeStatistics getStatistics(ThreadPool* pool = nullptr) const = 0;
+
+	/**
+	 * Calls sink(key, depth, rank value) for every node in key order, all in a
+	 * single traversal.
+	 *
+	 * @param sink callback receiving each node's key, depth and rank value
+	 */
+	virtual void depthProfile(const std::function<void(const KeyType&, unsigned, uint64_t)>& sink) const = 0;
+
+	/**
+	 * @return bytes held by the nodes, broken down by field, with allocator
+	 *         slack and reserved capacity
+	 */
+	virtual MemoryUsage memoryUsage() const noexcept = 0;
+
+	/**
+	 * Makes finds, inserts and removes count their structural work into the
+	 * given counters from now on, if the tree supports it.
+	 *
+	 * @param  counters counters to add to, or nullptr to stop counting
+	 * @return          false if the tree doesn't count structural work
+	 */
+	virtual bool setStructuralCounters(StructuralCounters* /* counters */) noexcept
+	{
+		return false;
+	}
 };
 
 template <typename KeyType, typename RankType>
@@ -35,6 +89,26 @@ public:
 	double getAverageHeight() const noexcept;
 	unsigned getSize() const noexcept;
 	bool find(const KeyType& key) const noexcept;
+	unsigned countRange(const KeyType& low, const KeyType& high) const noexcept;
+	TreeStatistics getStatistics(ThreadPool* pool = nullptr) const;
+	MemoryUsage memoryUsage() const noexcept;
+
+	/**
+	 * Calls sink(key, depth, rank value) for every node in key order, all in a
+	 * single traversal. The sink may be any callable, or a DepthProfileFile.
+	 *
+	 * @param sink callback receiving each node's key, depth and rank value
+	 */
+	template <typename Sink>
+	void depthProfile(Sink&& sink) const
+	{
+		emitDepthProfile(sink);
+	}
+
+	void depthProfile(const std::function<void(const KeyType&, unsigned, uint64_t)>& sink) const
+	{
+		emitDepthProfile(sink);
+	}
 
 	/**
 	 * @return total number of comparisons made
@@ -79,6 +153,9 @@ protected:
 private:
 	int getHeight(const std::unique_ptr<Node>& node) const noexcept;
 	uint64_t getTotalDepth(const std::unique_ptr<Node>& node, uint64_t depth) const noexcept;
+
+	template <typename Sink>
+	void emitDepthProfile(Sink& sink) const;
 };
 
 template <typename KeyType, typename RankType>
@@ -109,6 +186,44 @@ bool BinarySearchTreeRank<KeyType, RankType>::find(const KeyType& key) const noe
 	return false;
 }
 
+template <typename KeyType, typename RankType>
+unsigned BinarySearchTreeRank<KeyType, RankType>::countRange(const KeyType& low, const KeyType& high) const noexcept
+{
+	unsigned count = 0;
+	std::vector<const Node*> stack;
+
+	if (_head != nullptr)
+	{
+		stack.push_back(_head.get());
+	}
+
+	while (!stack.empty())
+	{
+		const Node* curr = stack.back();
+		stack.pop_back();
+
+		bool aboveLow = !(curr->key < low);
+		bool belowHigh = !(high < curr->key);
+
+		if (aboveLow && belowHigh)
+		{
+			++count;
+		}
+
+		if (aboveLow && curr->left != nullptr)
+		{
+			stack.push_back(curr->left.get());
+		}
+
+		if (belowHigh && curr->right != nullptr)
+		{
+			stack.push_back(curr->right.get());
+		}
+	}
+
+	return count;
+}
+
 template <typename KeyType, typename RankType>
 unsigned BinarySearchTreeRank<KeyType, RankType>::getSize() const noexcept
 {
@@ -174,5 +289,35 @@ uint64_t BinarySearchTreeRank<KeyType, RankType>::getTotalDepth(const std::uniqu
 	return getTotalDepth(node->left, depth + 1) + getTotalDepth(node->right, depth + 1) + depth;
 }
 
+template <typename KeyType, typename RankType>
+TreeStatistics BinarySearchTreeRank<KeyType, RankType>::getStatistics(ThreadPool* pool) const
+{
+	return collectTreeStatistics<RankType::HISTOGRAM_BY_VALUE>(
+		static_cast<const Node*>(_head.get()), static_cast<const Node*>(nullptr),
+		[](const Node* node) { return std::make_pair(static_cast<const Node*>(node->left.get()), static_cast<const Node*>(node->right.get())); },
+		[](const Node* node) { return node->rank.getValue(); },
+		pool);
+}
+
+template <typename KeyType, typename RankType>
+MemoryUsage BinarySearchTreeRank<KeyType, RankType>::memoryUsage() const noexcept
+{
+	MemoryUsage usage;
+	usage.addNodes(_size, sizeof(Node), sizeof(KeyType), sizeof(RankType), 2 * sizeof(std::unique_ptr<Node>));
+
+	// every node is its own allocation
+	usage.allocatorSlack = _size * (get_malloc_chunk_size(sizeof(Node)) - sizeof(Node));
+	return usage;
+}
+
+template <typename KeyType, typename RankType>
+template <typename Sink>
+void BinarySearchTreeRank<KeyType, RankType>::emitDepthProfile(Sink& sink) const
+{
+	traverseInOrder(static_cast<const Node*>(_head.get()), static_cast<const Node*>(nullptr),
+		[](const Node* node) { return std::make_pair(static_cast<const Node*>(node->left.get()), static_cast<const Node*>(node->right.get())); },
+		[&sink](const Node* node, unsigned depth) { sink(node->key, depth, node->rank.getValue()); });
+}
+
 
 #endif
\ No newline at end of file
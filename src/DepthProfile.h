@@ -0,0 +1,122 @@
+#ifndef DEPTHPROFILE_H
+#define DEPTHPROFILE_H
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Visits every node of a tree in key order using an explicit stack, passing
+ * each node reference along with its depth.
+ *
+ * @param root        root node reference, may be null
+ * @param null        the null node reference (nullptr or NULLPTR)
+ * @param getChildren returns a (left, right) pair for a node reference
+ * @param visit       called as visit(node, depth) for every node
+ */
+template <typename NodeRef, typename GetChildren, typename Visit>
+void traverseInOrder(NodeRef root, NodeRef null, GetChildren getChildren, Visit visit)
+{
+	struct Frame
+	{
+		NodeRef node;
+		unsigned depth;
+	};
+
+	std::vector<Frame> stack;
+	NodeRef cur = root;
+	unsigned depth = 0;
+
+	while (cur != null || !stack.empty())
+	{
+		while (cur != null)
+		{
+			stack.push_back({cur, depth});
+			cur = getChildren(cur).first;
+			++depth;
+		}
+
+		Frame frame = stack.back();
+		stack.pop_back();
+
+		visit(frame.node, frame.depth);
+
+		cur = getChildren(frame.node).second;
+		depth = frame.depth + 1;
+	}
+}
+
+/**
+ * One (key, depth, rank) entry of a depth profile, as laid out in the files
+ * written by DepthProfileFile.
+ */
+template <typename KeyType>
+struct DepthProfileRecord
+{
+	KeyType key;
+	uint32_t depth;
+	uint64_t rank;
+};
+
+/**
+ * Depth profile sink that writes fixed-size DepthProfileRecord entries into a
+ * memory-mapped file, so profiles of huge trees never have to fit in memory.
+ * Pass it to depthProfile in place of a callable sink.
+ */
+template <typename KeyType>
+class DepthProfileFile
+{
+public:
+	/**
+	 * @param path       file to create or overwrite
+	 * @param numRecords number of records the file holds, usually getSize()
+	 */
+	DepthProfileFile(const std::string& path, uint64_t numRecords)
+		: _file(path, MappedFile::Mode::Create, numRecords * sizeof(Record)), _numRecords(numRecords), _numWritten(0)
+	{
+	}
+
+	void operator()(const KeyType& key, unsigned depth, uint64_t rank)
+	{
+		if (_numWritten == _numRecords)
+		{
+			throw std::out_of_range("Depth profile file is full");
+		}
+
+		static_cast<Record*>(_file.getData())[_numWritten++] = {key, depth, rank};
+	}
+
+	/**
+	 * @return number of records written so far
+	 */
+	uint64_t getNumWritten() const noexcept
+	{
+		return _numWritten;
+	}
+
+	/**
+	 * Trims unused records and writes the profile back to disk.
+	 */
+	void close()
+	{
+		if (_numWritten != _numRecords)
+		{
+			_file.resize(_numWritten * sizeof(Record));
+			_numRecords = _numWritten;
+		}
+
+		_file.close();
+	}
+
+private:
+	typedef DepthProfileRecord<KeyType> Record;
+
+	MappedFile _file;
+	uint64_t _numRecords;
+	uint64_t _numWritten;
+};
+
+#endif
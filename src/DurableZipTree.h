@@ -0,0 +1,268 @@
+#ifndef DURABLEZIPTREE_H
+#define DURABLEZIPTREE_H
+
+#include "WriteAheadLog.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Durability layer for the array zip trees (any GeneralizedZipTree subclass).
+ * Every insert and remove is appended to a write-ahead log before it is
+ * applied, and recovery maps the latest snapshot and replays the log on top.
+ *
+ * Since the shape of a zip tree only depends on its keys and ranks, a log
+ * record is just the operation, the key and, for inserts, the rank, which is
+ * enough to rebuild the exact same structure. Only the fields of the rank that
+ * are compared are logged, not its counter pointers, which replay points at
+ * the counters of the recovering tree. Ranks that draw more random bits while
+ * being compared (DynamicZipTree) can't be replayed exactly.
+ *
+ * Replay uses set semantics: inserting a present key or removing an absent
+ * one does nothing. The final state of each key then only depends on the last
+ * record for it, so replaying records already included in the snapshot is
+ * harmless, which keeps checkpoints crash-safe without sequence numbers.
+ */
+template <typename Tree>
+class DurableZipTree
+{
+public:
+	typedef typename Tree::key_type KeyType;
+	typedef typename Tree::rank_type RankType;
+
+	/**
+	 * Recovers the tree from a snapshot (if it exists) and a log (if it
+	 * exists), then keeps logging to the same log.
+	 *
+	 * @param snapshotPath snapshot written by checkpoint
+	 * @param logPath      write-ahead log file
+	 * @param options      group commit and fsync batching options
+	 * @param treeArgs     constructor arguments of the tree
+	 */
+	template <typename... TreeArgs>
+	DurableZipTree(const std::string& snapshotPath, const std::string& logPath, WriteAheadLog::Options options, TreeArgs&&... treeArgs);
+
+	/**
+	 * Logs and inserts a key, unless it is already present.
+	 *
+	 * @param  key key to insert
+	 * @return     true if the key was inserted
+	 */
+	bool insert(const KeyType& key);
+
+	/**
+	 * Logs and removes a key, if it is present.
+	 *
+	 * @param  key key to remove
+	 * @return     true if the key was removed
+	 */
+	bool remove(const KeyType& key);
+
+	/**
+	 * Commits the current group of records, fsyncing if the sync interval has
+	 * passed. Call this at the end of each batch of operations.
+	 *
+	 * Groups committed within the interval of the last fsync are only synced
+	 * by a later commit or sync, so without one they may stay unsynced
+	 * indefinitely; call sync before going idle.
+	 */
+	void commit()
+	{
+		_log.commit();
+	}
+
+	/**
+	 * Makes every logged operation durable before returning.
+	 */
+	void sync()
+	{
+		_log.sync();
+	}
+
+	/**
+	 * Writes a new snapshot of the tree and empties the log.
+	 */
+	void checkpoint();
+
+	const Tree& getTree() const noexcept
+	{
+		return _tree;
+	}
+
+	/**
+	 * @return number of log records replayed during recovery
+	 */
+	uint64_t getNumReplayed() const noexcept
+	{
+		return _numReplayed;
+	}
+
+private:
+	static_assert(std::is_trivially_copyable_v<KeyType> && std::is_trivially_copyable_v<RankType>, "logged keys and ranks must be trivially copyable");
+	static_assert(std::is_standard_layout_v<RankType>, "logged ranks must be standard layout");
+
+	enum Operation : uint8_t
+	{
+		INSERT = 1,
+		REMOVE = 2
+	};
+
+	// the rank fields compared, which come before the counter pointers
+	static constexpr size_t RANK_VALUE_SIZE = offsetof(RankType, totalComparisons);
+	static constexpr size_t INSERT_RECORD_SIZE = 1 + sizeof(KeyType) + RANK_VALUE_SIZE;
+	static constexpr size_t REMOVE_RECORD_SIZE = 1 + sizeof(KeyType);
+
+	Tree _tree;
+	WriteAheadLog _log;
+	std::string _snapshotPath;
+	uint64_t _numReplayed;
+
+	void replay(const char* data, size_t bytes);
+
+	/**
+	 * Opens a file or directory and fsyncs it.
+	 *
+	 * @param path  file or directory to sync
+	 * @param flags extra open flags, e.g. O_DIRECTORY
+	 */
+	static void syncPath(const std::string& path, int flags);
+};
+
+template <typename Tree>
+template <typename... TreeArgs>
+DurableZipTree<Tree>::DurableZipTree(const std::string& snapshotPath, const std::string& logPath, WriteAheadLog::Options options, TreeArgs&&... treeArgs)
+	: _tree(std::forward<TreeArgs>(treeArgs)...), _snapshotPath(snapshotPath), _numReplayed(0)
+{
+	if (::access(snapshotPath.c_str(), F_OK) == 0)
+	{
+		_tree.openSnapshot(snapshotPath);
+	}
+
+	_log.open(logPath, options, [this](const char* data, size_t bytes) { replay(data, bytes); });
+}
+
+template <typename Tree>
+void DurableZipTree<Tree>::replay(const char* data, size_t bytes)
+{
+	const char* end = data + bytes;
+
+	while (data < end)
+	{
+		KeyType key;
+		std::memcpy(&key, data + 1, sizeof(KeyType));
+
+		if (data[0] == INSERT)
+		{
+			// insert binds the counters of the rebuilt rank to the tree
+			RankType rank{};
+			std::memcpy(&rank, data + 1 + sizeof(KeyType), RANK_VALUE_SIZE);
+
+			if (!_tree.find(key))
+			{
+				_tree.insert(key, rank);
+			}
+
+			data += INSERT_RECORD_SIZE;
+		}
+		else if (data[0] == REMOVE)
+		{
+			_tree.remove(key);
+			data += REMOVE_RECORD_SIZE;
+		}
+		else
+		{
+			throw std::runtime_error("Unknown operation in zip tree log");
+		}
+
+		++_numReplayed;
+	}
+}
+
+template <typename Tree>
+bool DurableZipTree<Tree>::insert(const KeyType& key)
+{
+	if (_tree.find(key))
+	{
+		return false;
+	}
+
+	RankType rank = _tree.sampleRank();
+
+	char record[INSERT_RECORD_SIZE];
+	record[0] = INSERT;
+	std::memcpy(record + 1, &key, sizeof(KeyType));
+	std::memcpy(record + 1 + sizeof(KeyType), &rank, RANK_VALUE_SIZE);
+	_log.append(record, sizeof(record));
+
+	_tree.insert(key, rank);
+	return true;
+}
+
+template <typename Tree>
+bool DurableZipTree<Tree>::remove(const KeyType& key)
+{
+	if (!_tree.find(key))
+	{
+		return false;
+	}
+
+	char record[REMOVE_RECORD_SIZE];
+	record[0] = REMOVE;
+	std::memcpy(record + 1, &key, sizeof(KeyType));
+	_log.append(record, sizeof(record));
+
+	return _tree.remove(key);
+}
+
+template <typename Tree>
+void DurableZipTree<Tree>::checkpoint()
+{
+	_log.sync();
+
+	// write the snapshot aside and rename it into place, so a crash leaves
+	// either the old or the new snapshot, each valid with the current log
+	std::string tempPath = _snapshotPath + ".tmp";
+	_tree.saveSnapshot(tempPath);
+	syncPath(tempPath, 0);
+
+	if (std::rename(tempPath.c_str(), _snapshotPath.c_str()) != 0)
+	{
+		throw std::runtime_error("Failed to rename snapshot to " + _snapshotPath + ": " + std::strerror(errno));
+	}
+
+	// the rename must be durable before the log is emptied, or a crash could
+	// lose both the new snapshot and the records it replaced
+	std::filesystem::path directory = std::filesystem::path(_snapshotPath).parent_path();
+	syncPath(directory.empty() ? "." : directory.string(), O_DIRECTORY);
+
+	_log.reset();
+}
+
+template <typename Tree>
+void DurableZipTree<Tree>::syncPath(const std::string& path, int flags)
+{
+	int fd = ::open(path.c_str(), O_RDONLY | flags);
+	if (fd == -1 || ::fsync(fd) == -1)
+	{
+		int error = errno;
+		if (fd != -1)
+		{
+			::close(fd);
+		}
+		throw std::runtime_error("Failed to sync " + path + ": " + std::strerror(error));
+	}
+	::close(fd);
+}
+
+#endif
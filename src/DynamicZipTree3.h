@@ -3,21 +3,11 @@
 
 #include "GeneralizedZipTree.h"
 
-#include <array>
 #include <limits>
 #include <random>
 
 #include <iostream>
 
-constexpr std::array<uint8_t, 256> BITS_REQUIRED = []{
-	std::array<uint8_t, 256> table{};
-	for (size_t i = 0; i < table.size(); i++)
-		for (uint8_t j = i; j > 0; j >>= 1)
-			table[i]++;
-	table[0] = 1;
-	return table;
-}();
-
 struct GeometricDynamicUniformRank
 {
 	uint64_t grank;
@@ -27,15 +17,22 @@ struct GeometricDynamicUniformRank
 	uint64_t* bothTies;
 	uint8_t num_bits = 0;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return grank;
+	}
+
 	inline void addBit() noexcept
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
 
-		static std::uniform_int_distribution<uint64_t> udistribution(0, std::numeric_limits<uint64_t>::max());
+		thread_local std::uniform_int_distribution<uint64_t> udistribution(0, std::numeric_limits<uint64_t>::max());
 
-		static uint64_t random_number;
-		static unsigned bit_index = sizeof(random_number) * 8;
+		thread_local uint64_t random_number;
+		thread_local unsigned bit_index = sizeof(random_number) * 8;
 
 		if (bit_index == sizeof(random_number) * 8)
 		{
@@ -110,26 +107,6 @@ struct GeometricDynamicUniformRank
 	}
 };
 
-namespace
-{
-	inline uint8_t num_bits_required(uint64_t value)
-	{
-		if (value <= BITS_REQUIRED.size())
-		{
-			return BITS_REQUIRED[value];
-		}
-
-		uint8_t bits = 0;
-		while (value > 0)
-		{
-			++bits;
-			value >>= 1;
-		}
-
-		return bits;
-	}
-}
-
 template <typename KeyType>
 class DynamicZipTree : public GeneralizedZipTree<KeyType, GeometricDynamicUniformRank>
 {
@@ -216,9 +193,9 @@ public:
 protected:
 	GeometricDynamicUniformRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
-		static std::geometric_distribution<uint64_t> gdistribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
+		thread_local std::geometric_distribution<uint64_t> gdistribution(0.5);
 
 		return {gdistribution(generator), 0uLL, totalComparisons, firstTies, bothTies};
 	}
@@ -2,21 +2,144 @@
 #define GENERALIZEDZIPTREE_H
 
 #include "BinarySearchTree.h"
+#include "MappedArray.h"
 
+#include <unistd.h>
+
+#include <concepts>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
-template <typename KeyType, typename RankType>
+namespace
+{
+	/**
+	 * @return FNV-1a hash of a type's name, used to tag snapshot files
+	 */
+	template <typename T>
+	uint64_t get_type_hash() noexcept
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (const char* c = typeid(T).name(); *c != '\0'; ++c)
+		{
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
+
+/**
+ * Types that keys can be looked up by: KeyType itself, or anything when the
+ * comparator is transparent, like std::less<>, so that e.g. a tree of
+ * std::string can be searched for a std::string_view or a string literal
+ * without constructing a temporary key.
+ */
+template <typename K, typename KeyType, typename Compare>
+concept LookupKey = std::same_as<K, KeyType> || requires { typename Compare::is_transparent; };
+
+/**
+ * Keys are ordered by Compare, a strict weak ordering, which is the only
+ * comparison ever made between keys: two keys are equal when neither is less
+ * than the other.
+ */
+template <typename KeyType, typename RankType, typename Compare = std::less<KeyType>>
 class GeneralizedZipTree: public BinarySearchTree<KeyType>
 {
 public:
-	GeneralizedZipTree(unsigned maxSize);
+	typedef KeyType key_type;
+	typedef RankType rank_type;
+	typedef Compare key_compare;
+
+	GeneralizedZipTree(unsigned maxSize, const Compare& compare = Compare());
+	~GeneralizedZipTree();
 
-	int getDepth(const KeyType& key) const noexcept;
 	int getHeight() const noexcept;
 	double getAverageHeight() const noexcept;
 	unsigned getSize() const noexcept;
-	bool find(const KeyType& key) const noexcept;
+	TreeStatistics getStatistics(ThreadPool* pool = nullptr) const;
+
+	int getDepth(const KeyType& key) const noexcept
+	{
+		return getDepth<KeyType>(key);
+	}
+
+	bool find(const KeyType& key) const noexcept
+	{
+		return find<KeyType>(key);
+	}
+
+	unsigned countRange(const KeyType& low, const KeyType& high) const noexcept
+	{
+		return countRange<KeyType>(low, high);
+	}
+
+	/**
+	 * Lookups by any LookupKey, e.g. find(std::string_view) on a tree of
+	 * std::string with std::less<> as its comparator.
+	 */
+	template <LookupKey<KeyType, Compare> K>
+	int getDepth(const K& key) const noexcept;
+
+	template <LookupKey<KeyType, Compare> K>
+	bool find(const K& key) const noexcept;
+
+	template <LookupKey<KeyType, Compare> K>
+	unsigned countRange(const K& low, const K& high) const noexcept;
+
+	const Compare& getCompare() const noexcept
+	{
+		return _compare;
+	}
+
+	/**
+	 * Reports the buckets and the capacity reserved past them, which for the
+	 * maxSize reserved by the constructor is usually most of the total.
+	 */
+	MemoryUsage memoryUsage() const noexcept;
+
+	/**
+	 * Calls sink(key, depth, rank value) for every node in key order, all in a
+	 * single traversal. The sink may be any callable, or a DepthProfileFile.
+	 *
+	 * @param sink callback receiving each node's key, depth and rank value
+	 */
+	template <typename Sink>
+	void depthProfile(Sink&& sink) const
+	{
+		emitDepthProfile(sink);
+	}
+
+	void depthProfile(const std::function<void(const KeyType&, unsigned, uint64_t)>& sink) const
+	{
+		emitDepthProfile(sink);
+	}
+
+	/**
+	 * Calls visit(key) for every key within [low, high], in increasing order.
+	 *
+	 * @param low   smallest key to visit
+	 * @param high  largest key to visit
+	 * @param visit callback receiving each key
+	 */
+	template <typename Visit>
+	void forEachInRange(const KeyType& low, const KeyType& high, Visit&& visit) const
+	{
+		forEachIndexInRange(low, high, [this, &visit](unsigned index) { visit(_buckets[index].key); });
+	}
+
+	template <LookupKey<KeyType, Compare> K, typename Visit>
+	void forEachInRange(const K& low, const K& high, Visit&& visit) const
+	{
+		forEachIndexInRange(low, high, [this, &visit](unsigned index) { visit(_buckets[index].key); });
+	}
 
 	/**
 	 * Inserts a key, value pair into the zip tree. Note that inserting there is
@@ -29,12 +152,81 @@ public:
 	void insert(const KeyType& key) noexcept;
 
 	/**
-	 * Removes a node with a given key from the zip tree.
+	 * Inserts a key with a given rank, e.g. one drawn earlier by sampleRank.
+	 * Since the shape of a zip tree only depends on its keys and ranks, this
+	 * reproduces the exact structure an earlier insertion would have had. The
+	 * same uniqueness requirement as insert applies.
+	 *
+	 * @param key  new node key
+	 * @param rank new node rank
+	 */
+	void insert(const KeyType& key, RankType rank) noexcept;
+
+	/**
+	 * Removes a node with a given key from the zip tree. The last bucket is
+	 * moved into the freed slot, so buckets stay densely packed.
 	 *
 	 * @param  key key of node to remove
 	 * @return     true if a node was removed, false otherwise
 	 */
-	// bool remove(const KeyType& key) noexcept;
+	bool remove(const KeyType& key) noexcept
+	{
+		return remove<KeyType>(key);
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	bool remove(const K& key) noexcept;
+
+	/**
+	 * Looks up a key starting from the right spine instead of the root: the
+	 * search climbs the spine from its bottom to the lowest node with a smaller
+	 * key and descends from there, so it costs O(log d) for a key with d
+	 * larger keys in the tree. Suits lookups of recently appended keys.
+	 *
+	 * Unlike find, this may rebuild the cached right spine first, so it is not
+	 * const and must not run concurrently with other calls on the tree, and it
+	 * terminates if the spine cannot be allocated.
+	 *
+	 * @param  key key to look up
+	 * @return     true if the key was found, false otherwise
+	 */
+	bool fingerFind(const KeyType& key) noexcept
+	{
+		return fingerFind<KeyType>(key);
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	bool fingerFind(const K& key) noexcept;
+
+	/**
+	 * Inserts a key starting from the right spine instead of the root, in
+	 * O(log d) expected time for a key with d larger keys in the tree. Appends
+	 * of keys larger than every other key take amortized constant time. The
+	 * spine is kept up to date by finger inserts and rebuilt from the root
+	 * after any other change, so runs of finger inserts pay for that once. As
+	 * with insert, the key must not already exist.
+	 *
+	 * @param key key of node to insert
+	 */
+	void fingerInsert(const KeyType& key) noexcept;
+	void fingerInsert(const KeyType& key, RankType rank) noexcept;
+
+	/**
+	 * Draws a fresh rank for every node (see redrawRank) and relinks the tree
+	 * into the zip tree of those ranks. Buckets stay where they are and only their ranks and
+	 * links change, so this runs in linear time without allocating nodes,
+	 * also on mapped buckets.
+	 */
+	void rerank();
+
+	/**
+	 * @return a random rank from this tree's rank distribution, counting its
+	 *         comparisons towards this tree
+	 */
+	RankType sampleRank() noexcept
+	{
+		return getRandomRank(&_totalComparisons, &_firstTies, &_bothTies);
+	}
 
 	/**
 	 * @return total number of comparisons made
@@ -65,11 +257,91 @@ public:
 		return _buckets[_rootIndex].rank;
 	}
 
+	/**
+	 * Writes the tree to a versioned binary snapshot file. Since nodes are
+	 * linked by index, the buckets are written out as-is. Requires trivially
+	 * copyable keys and ranks.
+	 *
+	 * @param path file to create or overwrite
+	 */
+	void saveSnapshot(const std::string& path) const;
+
+	/**
+	 * Replaces the contents of the tree with a snapshot written by
+	 * saveSnapshot. The buckets are mapped copy-on-write rather than read, so
+	 * this takes the same time for any tree size and pages are only faulted in
+	 * when queries touch them. Changes are never written back to the file.
+	 *
+	 * Ranks keep the comparison counter pointers they were saved with, and
+	 * are rebound (see bindRank) before they are ever compared.
+	 *
+	 * @param path    snapshot file to map
+	 * @param maxSize number of nodes to reserve address space for, so inserts
+	 *                after loading don't copy the mapped buckets
+	 */
+	void openSnapshot(const std::string& path, unsigned maxSize = 0);
+
+	/**
+	 * Moves the buckets into a memory-mapped file that grows with the tree, so
+	 * the OS can page cold subtrees out instead of holding the whole tree in
+	 * RAM. The file uses the snapshot format; its header is brought up to date
+	 * by flushBuckets and when the tree is destroyed.
+	 *
+	 * Links are written to the file as they change while the header only
+	 * follows on flushes, so the header is marked as closed cleanly only when
+	 * the tree is destroyed, and a file left behind by a crash is refused.
+	 *
+	 * The file starts out with room for the maxSize the tree was constructed
+	 * with. Inserts past that grow the file, and since insert is noexcept, a
+	 * failure to grow it (e.g. a full disk) calls std::terminate.
+	 *
+	 * @param path file to create or overwrite
+	 */
+	void createBucketFile(const std::string& path);
+
+	/**
+	 * Replaces the contents of the tree with a file set up by createBucketFile
+	 * (or a snapshot), keeping the buckets in that file from then on. The file
+	 * is marked as in use, durably, before this returns.
+	 *
+	 * @param path file to open read-write
+	 * @throws     std::runtime_error if the file wasn't closed cleanly
+	 */
+	void openBucketFile(const std::string& path);
+
+	/**
+	 * Updates the header of the bucket file and writes dirty pages back to
+	 * disk. Does nothing unless the buckets are kept in a file. The file stays
+	 * marked as in use, since later changes reach it before the header does.
+	 *
+	 * @param wait block until the pages have been written
+	 */
+	void flushBuckets(bool wait = true);
+
+	/**
+	 * Hints how mapped buckets are about to be accessed, e.g. Random before
+	 * lookups or DontNeed to drop cached pages of a bucket file, which is
+	 * flushed first. DontNeed is rejected for snapshots opened by
+	 * openSnapshot, since it would drop every change made since.
+	 *
+	 * @param advice expected access pattern
+	 * @throws       std::invalid_argument for DontNeed on an opened snapshot
+	 */
+	void adviseBuckets(MappingAdvice advice);
+
+	bool setStructuralCounters(StructuralCounters* counters) noexcept
+	{
+		_structuralCounters = counters;
+		return true;
+	}
+
 protected:
 	uint64_t _totalComparisons;
 	uint64_t _firstTies;
 	uint64_t _bothTies;
+	StructuralCounters* _structuralCounters = nullptr;
 	unsigned _rootIndex;
+	[[no_unique_address]] Compare _compare;
 
 	static constexpr unsigned NULLPTR = std::numeric_limits<unsigned>::max();
 
@@ -81,83 +353,410 @@ protected:
 		unsigned left = NULLPTR, right = NULLPTR;
 	};
 
-	std::vector<Bucket> _buckets;
+	// buckets of plain keys and ranks can be mapped straight from snapshots
+	typedef std::conditional_t<std::is_trivially_copyable_v<Bucket>, MappedArray<Bucket>, std::vector<Bucket>> BucketStorage;
+
+	BucketStorage _buckets;
 
 	virtual RankType getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept = 0;
 
+	/**
+	 * Draws the rank rerank gives a node, for subclasses whose ranks are not
+	 * entirely random.
+	 *
+	 * @param  rank current rank of the node
+	 * @return      new rank of the node
+	 */
+	virtual RankType redrawRank(const RankType& /* rank */) noexcept
+	{
+		return sampleRank();
+	}
+
+	/**
+	 * Points a rank's comparison counters at this tree's counters. Ranks that
+	 * were logged or loaded from a snapshot carry counter pointers from another
+	 * process, so they must be bound before they are compared as the left-hand
+	 * side of a comparison.
+	 *
+	 * @param rank rank to bind
+	 */
+	void bindRank(RankType& rank) noexcept
+	{
+		rank.totalComparisons = &_totalComparisons;
+		rank.firstTies = &_firstTies;
+		if constexpr (requires { rank.bothTies; })
+		{
+			rank.bothTies = &_bothTies;
+		}
+	}
+
+	/**
+	 * Zips two subtrees, where every key in x is smaller than every key in y.
+	 *
+	 * @param  x      root index of the left subtree
+	 * @param  y      root index of the right subtree
+	 * @param  length receives the number of nodes on the zipped path, each of
+	 *                which had a child link written
+	 * @return        root index of the zipped tree
+	 */
+	unsigned zip(unsigned x, unsigned y, unsigned& length) noexcept;
+
+	// bucket indices of the right spine from the root down; only valid while
+	// _isRightSpineValid, see getRightSpine. A deque, so that removing the
+	// root (e.g. SlidingWindowIndex::popFront) drops its front in O(1)
+	std::deque<unsigned> _rightSpine;
+	bool _isRightSpineValid = false;
+
+	/**
+	 * @return the right spine, rebuilt first if anything but a finger insert
+	 *         changed the tree since it was last valid
+	 */
+	const std::deque<unsigned>& getRightSpine();
+
+	/**
+	 * Links a newly added bucket below prevIndex, or makes it the root, and
+	 * unzips the path from curIndex into its subtrees, finishing an insert.
+	 *
+	 * @param xIndex         index of the new bucket
+	 * @param curIndex       node the new one takes the place of, or NULLPTR
+	 * @param prevIndex      parent of that place, or NULLPTR for the root
+	 * @param keyComparisons key comparisons made to find the place
+	 */
+	void linkAndUnzip(unsigned xIndex, unsigned curIndex, unsigned prevIndex, uint64_t keyComparisons) noexcept;
+
+	/**
+	 * Called when remove moves a bucket into the slot of a removed one, for
+	 * subclasses keeping data in arrays parallel to the buckets.
+	 *
+	 * @param from index the bucket was at, which is the last one
+	 * @param to   index the bucket is at now
+	 */
+	virtual void onBucketMoved(unsigned /* from */, unsigned /* to */) noexcept
+	{
+	}
+
+	/**
+	 * Calls visit(index) for the bucket of every key within [low, high], in
+	 * increasing order of keys, skipping the subtrees outside the range.
+	 */
+	template <typename K, typename Visit>
+	void forEachIndexInRange(const K& low, const K& high, Visit&& visit) const;
+
+	// descents over arithmetic keys, which are cheap to compare, pick the next
+	// node with arithmetic instead of branches: with random keys, a branch on
+	// the comparison is mispredicted at about every other level
+	static constexpr bool BRANCHLESS_DESCENT = std::is_arithmetic_v<KeyType>;
+
+	/**
+	 * @return the right child of a bucket if isRight holds and its left child
+	 *         otherwise, selected by masking rather than branching if
+	 *         BRANCHLESS_DESCENT
+	 */
+	static unsigned getChild(const Bucket& bucket, bool isRight) noexcept
+	{
+		if constexpr (BRANCHLESS_DESCENT)
+		{
+			return bucket.left ^ ((bucket.left ^ bucket.right) & -static_cast<unsigned>(isRight));
+		}
+		else
+		{
+			return isRight ? bucket.right : bucket.left;
+		}
+	}
+
+	/**
+	 * Prefetches the buckets of both children of a bucket. A missing child is
+	 * replaced by the bucket itself, since even computing the address of
+	 * bucket NULLPTR would be undefined.
+	 *
+	 * @param bucket bucket whose children to prefetch
+	 * @param index  index of the bucket
+	 */
+	void prefetchChildren(const Bucket& bucket, unsigned index) const noexcept
+	{
+		__builtin_prefetch(_buckets.data() + (bucket.left != NULLPTR ? bucket.left : index));
+		__builtin_prefetch(_buckets.data() + (bucket.right != NULLPTR ? bucket.right : index));
+	}
+
 private:
+	static constexpr char SNAPSHOT_MAGIC[8] = {'Z', 'I', 'P', 'T', 'R', 'E', 'E', '\0'};
+	static constexpr uint32_t SNAPSHOT_VERSION = 2;
+	// set in the header of snapshots and of bucket files that were closed,
+	// cleared while a bucket file is open
+	static constexpr uint32_t SNAPSHOT_CLEAN = 1;
+
+	struct SnapshotHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t bucketSize;
+		uint32_t keySize;
+		uint32_t rankSize;
+		uint64_t keyType;
+		uint64_t rankType;
+		// file offset of the first bucket, a multiple of the page size
+		uint64_t bucketOffset;
+		uint64_t size;
+		uint32_t rootIndex;
+		uint32_t flags;
+		uint64_t totalComparisons;
+		uint64_t firstTies;
+		uint64_t bothTies;
+	};
+
+	SnapshotHeader makeSnapshotHeader(bool isClean) const noexcept;
+	void checkSnapshotHeader(const SnapshotHeader& header, const std::string& path, uint64_t fileSize) const;
+	void writeBucketFileHeader(bool isClean = false) noexcept;
+
 	int getHeight(unsigned nodeIndex) const noexcept;
 	uint64_t getTotalDepth(unsigned nodeIndex, uint64_t depth) const noexcept;
+
+	template <typename Sink>
+	void emitDepthProfile(Sink& sink) const;
 };
 
-template <typename KeyType, typename RankType>
-GeneralizedZipTree<KeyType, RankType>::GeneralizedZipTree(unsigned maxSize): _rootIndex(NULLPTR),  _totalComparisons(0), _firstTies(0), _bothTies(0)
+template <typename KeyType, typename RankType, typename Compare>
+GeneralizedZipTree<KeyType, RankType, Compare>::GeneralizedZipTree(unsigned maxSize, const Compare& compare): _rootIndex(NULLPTR),  _totalComparisons(0), _firstTies(0), _bothTies(0), _compare(compare)
 {
 	_buckets.reserve(maxSize);
 }
 
-template <typename KeyType, typename RankType>
-bool GeneralizedZipTree<KeyType, RankType>::find(const KeyType& key) const noexcept
+template <typename KeyType, typename RankType, typename Compare>
+GeneralizedZipTree<KeyType, RankType, Compare>::~GeneralizedZipTree()
+{
+	if constexpr (std::is_trivially_copyable_v<Bucket>)
+	{
+		// the buckets must be on disk before the header says they are
+		// complete; the buckets release the file, syncing the header
+		if (_buckets.getFileHeader() != nullptr)
+		{
+			try
+			{
+				flushBuckets(true);
+				writeBucketFileHeader(true);
+			}
+			catch (const std::runtime_error&)
+			{
+			}
+		}
+	}
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+template <LookupKey<KeyType, Compare> K>
+bool GeneralizedZipTree<KeyType, RankType, Compare>::find(const K& key) const noexcept
 {
 	if (_buckets.empty())
 	{
 		return false;
 	}
 
+	// counts key comparisons for the structural counters
+	uint64_t keyComparisons = 0;
+	auto less = [this, &keyComparisons](const auto& a, const auto& b) noexcept
+	{
+		++keyComparisons;
+		return _compare(a, b);
+	};
+
 	unsigned curIndex = _rootIndex;
+	bool isFound = false;
 
-	while (curIndex != NULLPTR)
+	if constexpr (BRANCHLESS_DESCENT)
 	{
-		const auto& cur = _buckets[curIndex];
+		// only the direction is selected without a branch; the test for the
+		// key is a branch that is mispredicted at most once per search. Since
+		// the next node can't be loaded speculatively anymore, both children
+		// are prefetched while the keys are compared
+		while (curIndex != NULLPTR)
+		{
+			const auto& cur = _buckets[curIndex];
+			prefetchChildren(cur, curIndex);
+			bool isLeft = less(key, cur.key);
+			bool isRight = less(cur.key, key);
+			if (!isLeft && !isRight)
+			{
+				isFound = true;
+				break;
+			}
 
-		if (key < cur.key)
+			curIndex = getChild(cur, isRight);
+		}
+	}
+	else
+	{
+		while (curIndex != NULLPTR)
 		{
-			curIndex = cur.left;
+			const auto& cur = _buckets[curIndex];
+
+			if (less(key, cur.key))
+			{
+				curIndex = cur.left;
+			}
+			else if (less(cur.key, key))
+			{
+				curIndex = cur.right;
+			}
+			else
+			{
+				isFound = true;
+				break;
+			}
+		}
+	}
+
+	if (_structuralCounters != nullptr)
+	{
+		_structuralCounters->recordFind(keyComparisons);
+	}
+
+	return isFound;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+template <LookupKey<KeyType, Compare> K>
+unsigned GeneralizedZipTree<KeyType, RankType, Compare>::countRange(const K& low, const K& high) const noexcept
+{
+	unsigned count = 0;
+	std::vector<unsigned> stack;
+
+	if (!_buckets.empty())
+	{
+		stack.push_back(_rootIndex);
+	}
+
+	while (!stack.empty())
+	{
+		const auto& cur = _buckets[stack.back()];
+		stack.pop_back();
+
+		bool aboveLow = !_compare(cur.key, low);
+		bool belowHigh = !_compare(high, cur.key);
+
+		if (aboveLow && belowHigh)
+		{
+			++count;
+		}
+
+		if (aboveLow && cur.left != NULLPTR)
+		{
+			stack.push_back(cur.left);
 		}
-		else if (cur.key < key)
+
+		if (belowHigh && cur.right != NULLPTR)
 		{
-			curIndex = cur.right;
+			stack.push_back(cur.right);
+		}
+	}
+
+	return count;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+template <typename K, typename Visit>
+void GeneralizedZipTree<KeyType, RankType, Compare>::forEachIndexInRange(const K& low, const K& high, Visit&& visit) const
+{
+	std::vector<unsigned> stack;
+	unsigned curIndex = _buckets.empty() ? NULLPTR : _rootIndex;
+
+	while (curIndex != NULLPTR || !stack.empty())
+	{
+		if (curIndex != NULLPTR)
+		{
+			const auto& cur = _buckets[curIndex];
+			if (_compare(cur.key, low))
+			{
+				curIndex = cur.right;
+			}
+			else
+			{
+				stack.push_back(curIndex);
+				curIndex = cur.left;
+			}
 		}
 		else
 		{
-			return true;
+			unsigned index = stack.back();
+			stack.pop_back();
+
+			if (_compare(high, _buckets[index].key))
+			{
+				return;
+			}
+
+			visit(index);
+			curIndex = _buckets[index].right;
 		}
 	}
+}
 
-	return false;
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::insert(const KeyType& key) noexcept
+{
+	insert(key, getRandomRank(&_totalComparisons, &_firstTies, &_bothTies));
 }
 
-template <typename KeyType, typename RankType>
-void GeneralizedZipTree<KeyType, RankType>::insert(const KeyType& key) noexcept
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::insert(const KeyType& key, RankType rank) noexcept
 {
-	Bucket x = { key, getRandomRank(&_totalComparisons, &_firstTies, &_bothTies) };
+	bindRank(rank);
+	_isRightSpineValid = false;
+
+	Bucket x = { key, rank };
 	unsigned xIndex = _buckets.size();
 
 	if (xIndex == 0)
 	{
 		_rootIndex = xIndex;
 		_buckets.emplace_back(x);
+
+		if (_structuralCounters != nullptr)
+		{
+			_structuralCounters->recordInsert(0, 0, 1);
+		}
 		return;
 	}
 
-	auto& rank = x.rank;
+	// counts key comparisons for the structural counters
+	uint64_t keyComparisons = 0;
+	auto less = [this, &keyComparisons](const auto& a, const auto& b) noexcept
+	{
+		++keyComparisons;
+		return _compare(a, b);
+	};
 
 	unsigned curIndex = _rootIndex;
 	unsigned prevIndex = NULLPTR;
 
-	while (curIndex != NULLPTR && (rank < _buckets[curIndex].rank || (rank == _buckets[curIndex].rank && key > _buckets[curIndex].key)))
+	while (curIndex != NULLPTR && (x.rank < _buckets[curIndex].rank || (x.rank == _buckets[curIndex].rank && less(_buckets[curIndex].key, key))))
 	{
 		prevIndex = curIndex;
-		curIndex = key < _buckets[curIndex].key ? _buckets[curIndex].left : _buckets[curIndex].right;
+		curIndex = getChild(_buckets[curIndex], !less(key, _buckets[curIndex].key));
 	}
 
 	_buckets.emplace_back(x);
+	linkAndUnzip(xIndex, curIndex, prevIndex, keyComparisons);
+}
 
-	if (curIndex == _rootIndex)
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::linkAndUnzip(unsigned xIndex, unsigned curIndex, unsigned prevIndex, uint64_t keyComparisons) noexcept
+{
+	// continues counting the key comparisons of the caller
+	auto less = [this, &keyComparisons](const auto& a, const auto& b) noexcept
+	{
+		++keyComparisons;
+		return _compare(a, b);
+	};
+	unsigned unzipLength = 0;
+	unsigned linkWrites = 0;
+
+	const KeyType& key = _buckets[xIndex].key;
+
+	if (prevIndex == NULLPTR)
 	{
 		_rootIndex = xIndex;
 	}
-	else if (key < _buckets[prevIndex].key)
+	else if (less(key, _buckets[prevIndex].key))
 	{
 		_buckets[prevIndex].left = xIndex;
 	}
@@ -165,35 +764,37 @@ void GeneralizedZipTree<KeyType, RankType>::insert(const KeyType& key) noexcept
 	{
 		_buckets[prevIndex].right = xIndex;
 	}
+	++linkWrites;
 
-	if (curIndex == NULLPTR)
+	if (curIndex != NULLPTR)
 	{
-		return;
-	}
-
-	if (key < _buckets[curIndex].key)
-	{
-		_buckets[xIndex].right = curIndex;
-	}
-	else
-	{
-		_buckets[xIndex].left = curIndex;
+		if (less(key, _buckets[curIndex].key))
+		{
+			_buckets[xIndex].right = curIndex;
+		}
+		else
+		{
+			_buckets[xIndex].left = curIndex;
+		}
+		++linkWrites;
 	}
 
 	prevIndex = xIndex;
 
+	// unzip the path below x into its left and right subtrees
 	while (curIndex != NULLPTR)
 	{
 		unsigned fixIndex = prevIndex;
 
-		if (_buckets[curIndex].key < key)
+		if (less(_buckets[curIndex].key, key))
 		{
 			do
 			{
 				prevIndex = curIndex;
 				curIndex = _buckets[curIndex].right;
+				++unzipLength;
 			}
-			while (curIndex != NULLPTR && _buckets[curIndex].key < key);
+			while (curIndex != NULLPTR && less(_buckets[curIndex].key, key));
 		}
 		else
 		{
@@ -201,11 +802,12 @@ void GeneralizedZipTree<KeyType, RankType>::insert(const KeyType& key) noexcept
 			{
 				prevIndex = curIndex;
 				curIndex = _buckets[curIndex].left;
+				++unzipLength;
 			}
-			while (curIndex != NULLPTR && _buckets[curIndex].key > key);
+			while (curIndex != NULLPTR && less(key, _buckets[curIndex].key));
 		}
 
-		if (_buckets[fixIndex].key > key || (fixIndex == xIndex && _buckets[prevIndex].key > key))
+		if (less(key, _buckets[fixIndex].key) || (fixIndex == xIndex && less(key, _buckets[prevIndex].key)))
 		{
 			_buckets[fixIndex].left = curIndex;
 		}
@@ -213,24 +815,343 @@ void GeneralizedZipTree<KeyType, RankType>::insert(const KeyType& key) noexcept
 		{
 			_buckets[fixIndex].right = curIndex;
 		}
+		++linkWrites;
+	}
+
+	if (_structuralCounters != nullptr)
+	{
+		_structuralCounters->recordInsert(keyComparisons, unzipLength, linkWrites);
+	}
+}
+
+
+template <typename KeyType, typename RankType, typename Compare>
+template <LookupKey<KeyType, Compare> K>
+bool GeneralizedZipTree<KeyType, RankType, Compare>::fingerFind(const K& key) noexcept
+{
+	if (_buckets.empty())
+	{
+		return false;
+	}
+
+	// counts key comparisons for the structural counters
+	uint64_t keyComparisons = 0;
+	auto less = [this, &keyComparisons](const auto& a, const auto& b) noexcept
+	{
+		++keyComparisons;
+		return _compare(a, b);
+	};
+
+	const std::deque<unsigned>& spine = getRightSpine();
+
+	// spine nodes [0, split) have smaller keys, and every key between the
+	// last of them and spine[split] is in the subtree of spine[split]
+	size_t split = spine.size();
+	while (split > 0 && !less(_buckets[spine[split - 1]].key, key))
+	{
+		--split;
+	}
+
+	unsigned curIndex = split < spine.size() ? spine[split] : NULLPTR;
+	bool isFound = false;
+
+	while (curIndex != NULLPTR)
+	{
+		const auto& cur = _buckets[curIndex];
+
+		if (less(key, cur.key))
+		{
+			curIndex = cur.left;
+		}
+		else if (less(cur.key, key))
+		{
+			curIndex = cur.right;
+		}
+		else
+		{
+			isFound = true;
+			break;
+		}
+	}
+
+	if (_structuralCounters != nullptr)
+	{
+		_structuralCounters->recordFind(keyComparisons);
+	}
+
+	return isFound;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::fingerInsert(const KeyType& key) noexcept
+{
+	fingerInsert(key, getRandomRank(&_totalComparisons, &_firstTies, &_bothTies));
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::fingerInsert(const KeyType& key, RankType rank) noexcept
+{
+	if (_buckets.empty())
+	{
+		insert(key, rank);
+		return;
+	}
+
+	bindRank(rank);
+
+	Bucket x = { key, rank };
+	unsigned xIndex = _buckets.size();
+
+	// counts key comparisons for the structural counters
+	uint64_t keyComparisons = 0;
+	auto less = [this, &keyComparisons](const auto& a, const auto& b) noexcept
+	{
+		++keyComparisons;
+		return _compare(a, b);
+	};
+
+	const std::deque<unsigned>& spine = getRightSpine();
+
+	// spine nodes [0, split) have smaller keys than x
+	size_t split = spine.size();
+	while (split > 0 && !less(_buckets[spine[split - 1]].key, key))
+	{
+		--split;
+	}
+
+	// ranks don't increase down the spine, so the smaller spine nodes x
+	// outranks are the ones in [position, split); x.rank is compared on the
+	// left, since spine ranks loaded from a snapshot aren't bound yet
+	size_t position = split;
+	while (position > 0 && x.rank > _buckets[spine[position - 1]].rank)
+	{
+		--position;
+	}
+
+	unsigned curIndex;
+	unsigned prevIndex;
+
+	if (position < split || split == spine.size() || !(x.rank < _buckets[spine[split]].rank))
+	{
+		// x joins the spine, taking over the larger part of it; the smaller
+		// spine nodes below it are unzipped into its left subtree
+		curIndex = position < spine.size() ? spine[position] : NULLPTR;
+		prevIndex = position > 0 ? spine[position - 1] : NULLPTR;
+
+		_rightSpine.erase(_rightSpine.begin() + position, _rightSpine.begin() + split);
+		_rightSpine.insert(_rightSpine.begin() + position, xIndex);
+	}
+	else
+	{
+		// x goes into the left subtree of spine[split], off the spine
+		prevIndex = spine[split];
+		curIndex = _buckets[prevIndex].left;
+
+		while (curIndex != NULLPTR && (x.rank < _buckets[curIndex].rank || (x.rank == _buckets[curIndex].rank && less(_buckets[curIndex].key, key))))
+		{
+			prevIndex = curIndex;
+			curIndex = getChild(_buckets[curIndex], !less(key, _buckets[curIndex].key));
+		}
 	}
+
+	_buckets.emplace_back(x);
+	linkAndUnzip(xIndex, curIndex, prevIndex, keyComparisons);
 }
 
+template <typename KeyType, typename RankType, typename Compare>
+template <LookupKey<KeyType, Compare> K>
+bool GeneralizedZipTree<KeyType, RankType, Compare>::remove(const K& key) noexcept
+{
+	_isRightSpineValid = false;
+
+	// counts key comparisons for the structural counters
+	uint64_t keyComparisons = 0;
+	auto less = [this, &keyComparisons](const auto& a, const auto& b) noexcept
+	{
+		++keyComparisons;
+		return _compare(a, b);
+	};
+
+	unsigned* link = &_rootIndex;
+
+	while (!_buckets.empty() && *link != NULLPTR)
+	{
+		auto& cur = _buckets[*link];
+
+		if (less(key, cur.key))
+		{
+			link = &cur.left;
+		}
+		else if (less(cur.key, key))
+		{
+			link = &cur.right;
+		}
+		else
+		{
+			unsigned zipLength;
+			unsigned removedIndex = *link;
+			*link = zip(cur.left, cur.right, zipLength);
+			unsigned linkWrites = zipLength + 1;
 
-template <typename KeyType, typename RankType>
-unsigned GeneralizedZipTree<KeyType, RankType>::getSize() const noexcept
+			// move the last bucket into the freed slot, relinking its parent
+			unsigned lastIndex = _buckets.size() - 1;
+			if (removedIndex != lastIndex)
+			{
+				const KeyType& lastKey = _buckets[lastIndex].key;
+				unsigned* lastLink = &_rootIndex;
+
+				while (*lastLink != lastIndex)
+				{
+					lastLink = less(lastKey, _buckets[*lastLink].key) ? &_buckets[*lastLink].left : &_buckets[*lastLink].right;
+				}
+
+				*lastLink = removedIndex;
+				_buckets[removedIndex] = _buckets[lastIndex];
+				++linkWrites;
+
+				onBucketMoved(lastIndex, removedIndex);
+			}
+
+			_buckets.pop_back();
+			if (_buckets.empty())
+			{
+				_rootIndex = NULLPTR;
+				++linkWrites;
+			}
+
+			if (_structuralCounters != nullptr)
+			{
+				_structuralCounters->recordRemove(keyComparisons, zipLength, linkWrites, removedIndex != lastIndex);
+			}
+
+			return true;
+		}
+	}
+
+	// a failed remove only searched, like a find
+	if (_structuralCounters != nullptr)
+	{
+		_structuralCounters->recordFind(keyComparisons);
+	}
+
+	return false;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::rerank()
+{
+	_isRightSpineValid = false;
+
+	std::vector<unsigned> order;
+	std::vector<unsigned> stack;
+	order.reserve(_buckets.size());
+
+	// bucket indices in key order
+	unsigned curIndex = _buckets.empty() ? NULLPTR : _rootIndex;
+	while (curIndex != NULLPTR || !stack.empty())
+	{
+		if (curIndex != NULLPTR)
+		{
+			stack.push_back(curIndex);
+			curIndex = _buckets[curIndex].left;
+		}
+		else
+		{
+			curIndex = stack.back();
+			stack.pop_back();
+			order.push_back(curIndex);
+			curIndex = _buckets[curIndex].right;
+		}
+	}
+
+	// the zip tree is the Cartesian tree of the ranks, where ties go to the
+	// smaller key, so build it left to right on a stack of its right spine
+	for (unsigned index : order)
+	{
+		Bucket& x = _buckets[index];
+		x.rank = redrawRank(x.rank);
+
+		unsigned lastPopped = NULLPTR;
+		while (!stack.empty() && _buckets[stack.back()].rank < x.rank)
+		{
+			lastPopped = stack.back();
+			stack.pop_back();
+		}
+
+		x.left = lastPopped;
+		x.right = NULLPTR;
+		if (!stack.empty())
+		{
+			_buckets[stack.back()].right = index;
+		}
+
+		stack.push_back(index);
+	}
+
+	_rootIndex = stack.empty() ? NULLPTR : stack.front();
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+const std::deque<unsigned>& GeneralizedZipTree<KeyType, RankType, Compare>::getRightSpine()
+{
+	if (!_isRightSpineValid)
+	{
+		_rightSpine.clear();
+		for (unsigned curIndex = _buckets.empty() ? NULLPTR : _rootIndex; curIndex != NULLPTR; curIndex = _buckets[curIndex].right)
+		{
+			_rightSpine.push_back(curIndex);
+		}
+
+		_isRightSpineValid = true;
+	}
+
+	return _rightSpine;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+unsigned GeneralizedZipTree<KeyType, RankType, Compare>::zip(unsigned x, unsigned y, unsigned& length) noexcept
+{
+	unsigned root = NULLPTR;
+	unsigned* link = &root;
+	length = 0;
+
+	while (x != NULLPTR && y != NULLPTR)
+	{
+		++length;
+		bindRank(_buckets[x].rank);
+
+		if (_buckets[x].rank < _buckets[y].rank)
+		{
+			*link = y;
+			link = &_buckets[y].left;
+			y = _buckets[y].left;
+		}
+		else
+		{
+			*link = x;
+			link = &_buckets[x].right;
+			x = _buckets[x].right;
+		}
+	}
+
+	*link = x != NULLPTR ? x : y;
+	return root;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+unsigned GeneralizedZipTree<KeyType, RankType, Compare>::getSize() const noexcept
 {
 	return _buckets.size();
 }
 
-template <typename KeyType, typename RankType>
-int GeneralizedZipTree<KeyType, RankType>::getHeight() const noexcept
+template <typename KeyType, typename RankType, typename Compare>
+int GeneralizedZipTree<KeyType, RankType, Compare>::getHeight() const noexcept
 {
 	return getHeight(_rootIndex);
 }
 
-template <typename KeyType, typename RankType>
-int GeneralizedZipTree<KeyType, RankType>::getHeight(unsigned nodeIndex) const noexcept
+template <typename KeyType, typename RankType, typename Compare>
+int GeneralizedZipTree<KeyType, RankType, Compare>::getHeight(unsigned nodeIndex) const noexcept
 {
 	if (nodeIndex == NULLPTR)
 	{
@@ -240,19 +1161,40 @@ int GeneralizedZipTree<KeyType, RankType>::getHeight(unsigned nodeIndex) const n
 	return std::max(getHeight(_buckets[nodeIndex].left), getHeight(_buckets[nodeIndex].right)) + 1;
 }
 
-template <typename KeyType, typename RankType>
-int GeneralizedZipTree<KeyType, RankType>::getDepth(const KeyType& key) const noexcept
+template <typename KeyType, typename RankType, typename Compare>
+template <LookupKey<KeyType, Compare> K>
+int GeneralizedZipTree<KeyType, RankType, Compare>::getDepth(const K& key) const noexcept
 {
 	unsigned curIndex = _rootIndex;
 	int depth = 0;
 
+	if constexpr (BRANCHLESS_DESCENT)
+	{
+		// as in find
+		for (; curIndex != NULLPTR; ++depth)
+		{
+			const auto& cur = _buckets[curIndex];
+			prefetchChildren(cur, curIndex);
+			bool isLeft = _compare(key, cur.key);
+			bool isRight = _compare(cur.key, key);
+			if (!isLeft && !isRight)
+			{
+				return depth;
+			}
+
+			curIndex = getChild(cur, isRight);
+		}
+
+		return -1;
+	}
+
 	while (curIndex != NULLPTR)
 	{
-		if (key < _buckets[curIndex].key)
+		if (_compare(key, _buckets[curIndex].key))
 		{
 			curIndex = _buckets[curIndex].left;
 		}
-		else if (_buckets[curIndex].key < key)
+		else if (_compare(_buckets[curIndex].key, key))
 		{
 			curIndex = _buckets[curIndex].right;
 		}
@@ -267,14 +1209,14 @@ int GeneralizedZipTree<KeyType, RankType>::getDepth(const KeyType& key) const no
 	return -1;
 }
 
-template <typename KeyType, typename RankType>
-double GeneralizedZipTree<KeyType, RankType>::getAverageHeight() const noexcept
+template <typename KeyType, typename RankType, typename Compare>
+double GeneralizedZipTree<KeyType, RankType, Compare>::getAverageHeight() const noexcept
 {
 	return static_cast<double>(getTotalDepth(_rootIndex, 0)) / getSize();
 }
 
-template <typename KeyType, typename RankType>
-uint64_t GeneralizedZipTree<KeyType, RankType>::getTotalDepth(unsigned nodeIndex, uint64_t depth) const noexcept
+template <typename KeyType, typename RankType, typename Compare>
+uint64_t GeneralizedZipTree<KeyType, RankType, Compare>::getTotalDepth(unsigned nodeIndex, uint64_t depth) const noexcept
 {
 	if (nodeIndex == NULLPTR)
 	{
@@ -284,4 +1226,211 @@ uint64_t GeneralizedZipTree<KeyType, RankType>::getTotalDepth(unsigned nodeIndex
 	return getTotalDepth(_buckets[nodeIndex].left, depth + 1) + getTotalDepth(_buckets[nodeIndex].right, depth + 1) + depth;
 }
 
+template <typename KeyType, typename RankType, typename Compare>
+TreeStatistics GeneralizedZipTree<KeyType, RankType, Compare>::getStatistics(ThreadPool* pool) const
+{
+	return collectTreeStatistics<RankType::HISTOGRAM_BY_VALUE>(
+		_buckets.empty() ? NULLPTR : _rootIndex, NULLPTR,
+		[this](unsigned nodeIndex) { return std::make_pair(_buckets[nodeIndex].left, _buckets[nodeIndex].right); },
+		[this](unsigned nodeIndex) { return _buckets[nodeIndex].rank.getValue(); },
+		pool);
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+MemoryUsage GeneralizedZipTree<KeyType, RankType, Compare>::memoryUsage() const noexcept
+{
+	MemoryUsage usage;
+	usage.addNodes(_buckets.size(), sizeof(Bucket), sizeof(KeyType), sizeof(RankType), 2 * sizeof(unsigned));
+
+	size_t capacityBytes = _buckets.capacity() * sizeof(Bucket);
+	usage.capacityHeadroom = capacityBytes - _buckets.size() * sizeof(Bucket);
+
+	bool isMapped = false;
+	if constexpr (std::is_trivially_copyable_v<Bucket>)
+	{
+		isMapped = _buckets.getBacking() != BucketStorage::Backing::Heap;
+	}
+
+	if (capacityBytes > 0)
+	{
+		// mappings end on a page boundary, heap blocks are rounded by malloc
+		size_t pageSize = ::sysconf(_SC_PAGESIZE);
+		size_t blockBytes = isMapped ? (capacityBytes + pageSize - 1) / pageSize * pageSize : get_malloc_chunk_size(capacityBytes);
+		usage.allocatorSlack = blockBytes - capacityBytes;
+	}
+
+	return usage;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+typename GeneralizedZipTree<KeyType, RankType, Compare>::SnapshotHeader GeneralizedZipTree<KeyType, RankType, Compare>::makeSnapshotHeader(bool isClean) const noexcept
+{
+	SnapshotHeader header = {};
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	header.version = SNAPSHOT_VERSION;
+	header.bucketSize = sizeof(Bucket);
+	header.keySize = sizeof(KeyType);
+	header.rankSize = sizeof(RankType);
+	header.keyType = get_type_hash<KeyType>();
+	header.rankType = get_type_hash<RankType>();
+	header.bucketOffset = std::max<uint64_t>(::sysconf(_SC_PAGESIZE), sizeof(SnapshotHeader));
+	header.size = _buckets.size();
+	header.rootIndex = _rootIndex;
+	header.flags = isClean ? SNAPSHOT_CLEAN : 0;
+	header.totalComparisons = _totalComparisons;
+	header.firstTies = _firstTies;
+	header.bothTies = _bothTies;
+
+	return header;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::checkSnapshotHeader(const SnapshotHeader& header, const std::string& path, uint64_t fileSize) const
+{
+	if (fileSize < sizeof(SnapshotHeader) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+	{
+		throw std::runtime_error(path + " is not a zip tree snapshot");
+	}
+
+	if (header.version != SNAPSHOT_VERSION)
+	{
+		throw std::runtime_error(path + " has unsupported snapshot version " + std::to_string(header.version));
+	}
+
+	if (header.bucketSize != sizeof(Bucket) || header.keySize != sizeof(KeyType) || header.rankSize != sizeof(RankType)
+		|| header.keyType != get_type_hash<KeyType>() || header.rankType != get_type_hash<RankType>())
+	{
+		throw std::runtime_error(path + " was saved with different key or rank types");
+	}
+
+	if (header.bucketOffset % ::sysconf(_SC_PAGESIZE) != 0 || fileSize < header.bucketOffset + header.size * sizeof(Bucket))
+	{
+		throw std::runtime_error(path + " is truncated or has a misaligned bucket offset");
+	}
+
+	if ((header.flags & SNAPSHOT_CLEAN) == 0)
+	{
+		throw std::runtime_error(path + " is a bucket file that wasn't closed cleanly, so its header may not match its buckets");
+	}
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::saveSnapshot(const std::string& path) const
+{
+	static_assert(std::is_trivially_copyable_v<Bucket>, "snapshots require trivially copyable keys and ranks");
+
+	SnapshotHeader header = makeSnapshotHeader(true);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.seekp(header.bucketOffset);
+	file.write(reinterpret_cast<const char*>(_buckets.data()), _buckets.size() * sizeof(Bucket));
+
+	if (!file)
+	{
+		throw std::runtime_error("Failed to write snapshot " + path);
+	}
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::openSnapshot(const std::string& path, unsigned maxSize)
+{
+	static_assert(std::is_trivially_copyable_v<Bucket>, "snapshots require trivially copyable keys and ranks");
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		throw std::runtime_error("Failed to open snapshot " + path);
+	}
+
+	uint64_t fileSize = file.tellg();
+
+	SnapshotHeader header = {};
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	checkSnapshotHeader(header, path, fileSize);
+
+	_buckets.mapFile(path, header.bucketOffset, header.size, maxSize);
+	_rootIndex = header.rootIndex;
+	_isRightSpineValid = false;
+	_totalComparisons = header.totalComparisons;
+	_firstTies = header.firstTies;
+	_bothTies = header.bothTies;
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::createBucketFile(const std::string& path)
+{
+	static_assert(std::is_trivially_copyable_v<Bucket>, "bucket files require trivially copyable keys and ranks");
+
+	_buckets.createFile(path, makeSnapshotHeader(false).bucketOffset);
+	writeBucketFileHeader();
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::openBucketFile(const std::string& path)
+{
+	static_assert(std::is_trivially_copyable_v<Bucket>, "bucket files require trivially copyable keys and ranks");
+
+	SnapshotHeader header = {};
+	{
+		MappedFile file(path, MappedFile::Mode::ReadOnly);
+		std::memcpy(&header, file.getData(), std::min(file.getSize(), sizeof(header)));
+		checkSnapshotHeader(header, path, file.getSize());
+	}
+
+	_buckets.openFile(path, header.bucketOffset, header.size);
+	_rootIndex = header.rootIndex;
+	_isRightSpineValid = false;
+	_totalComparisons = header.totalComparisons;
+	_firstTies = header.firstTies;
+	_bothTies = header.bothTies;
+
+	// no link may reach the disk before the header stops claiming the file
+	// was closed cleanly
+	writeBucketFileHeader();
+	_buckets.flush(true);
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::flushBuckets(bool wait)
+{
+	static_assert(std::is_trivially_copyable_v<Bucket>, "bucket files require trivially copyable keys and ranks");
+
+	writeBucketFileHeader();
+	_buckets.flush(wait);
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::adviseBuckets(MappingAdvice advice)
+{
+	static_assert(std::is_trivially_copyable_v<Bucket>, "mapped buckets require trivially copyable keys and ranks");
+
+	if (advice == MappingAdvice::DontNeed)
+	{
+		writeBucketFileHeader();
+	}
+
+	_buckets.advise(advice);
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+void GeneralizedZipTree<KeyType, RankType, Compare>::writeBucketFileHeader(bool isClean) noexcept
+{
+	if (void* fileHeader = _buckets.getFileHeader())
+	{
+		SnapshotHeader header = makeSnapshotHeader(isClean);
+		std::memcpy(fileHeader, &header, sizeof(header));
+	}
+}
+
+template <typename KeyType, typename RankType, typename Compare>
+template <typename Sink>
+void GeneralizedZipTree<KeyType, RankType, Compare>::emitDepthProfile(Sink& sink) const
+{
+	traverseInOrder(_buckets.empty() ? NULLPTR : _rootIndex, NULLPTR,
+		[this](unsigned nodeIndex) { return std::make_pair(_buckets[nodeIndex].left, _buckets[nodeIndex].right); },
+		[this, &sink](unsigned nodeIndex, unsigned depth) { sink(_buckets[nodeIndex].key, depth, _buckets[nodeIndex].rank.getValue()); });
+}
+
 #endif
\ No newline at end of file
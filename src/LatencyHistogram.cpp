@@ -0,0 +1,115 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <thread>
+
+double get_ns_per_tick()
+{
+	static const double nsPerTick = []
+	{
+		auto start = std::chrono::steady_clock::now();
+		uint64_t startTicks = read_timestamp_counter();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		uint64_t endTicks = read_timestamp_counter();
+		auto end = std::chrono::steady_clock::now();
+
+		double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		return endTicks > startTicks ? ns / (endTicks - startTicks) : 1.0;
+	}();
+
+	return nsPerTick;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	if (other._counts.size() > _counts.size())
+	{
+		_counts.resize(other._counts.size());
+	}
+
+	for (size_t i = 0; i < other._counts.size(); ++i)
+	{
+		_counts[i] += other._counts[i];
+	}
+
+	_count += other._count;
+	_max = std::max(_max, other._max);
+}
+
+uint64_t LatencyHistogram::getQuantile(double quantile) const noexcept
+{
+	if (_count == 0)
+	{
+		return 0;
+	}
+
+	// the value of rank ceil(quantile * count), counting from 1
+	uint64_t rank = std::max<uint64_t>(std::ceil(quantile * _count), 1);
+	uint64_t seen = 0;
+
+	for (size_t i = 0; i < _counts.size(); ++i)
+	{
+		seen += _counts[i];
+		if (seen >= rank)
+		{
+			return std::min(getBucketMax(i), _max);
+		}
+	}
+
+	return _max;
+}
+
+void LatencyHistogram::save(std::ostream& out) const
+{
+	size_t numNonzero = std::count_if(_counts.begin(), _counts.end(), [](uint64_t count) { return count != 0; });
+	out << _count << " " << _max << " " << _counts.size() << " " << numNonzero;
+
+	for (size_t i = 0; i < _counts.size(); ++i)
+	{
+		if (_counts[i] != 0)
+		{
+			out << " " << i << " " << _counts[i];
+		}
+	}
+}
+
+void LatencyHistogram::load(std::istream& in)
+{
+	size_t numBuckets = 0;
+	size_t numNonzero = 0;
+	in >> _count >> _max >> numBuckets >> numNonzero;
+
+	_counts.assign(in ? numBuckets : 0, 0);
+	for (size_t i = 0; i < numNonzero && in; ++i)
+	{
+		size_t index;
+		uint64_t count;
+		in >> index >> count;
+
+		if (index >= _counts.size())
+		{
+			in.setstate(std::ios::failbit);
+			break;
+		}
+		_counts[index] = count;
+	}
+}
+
+uint64_t LatencyHistogram::getBucketMax(size_t index) noexcept
+{
+	if (index < SUB_BUCKET_COUNT)
+	{
+		return index;
+	}
+
+	size_t offset = index - SUB_BUCKET_COUNT;
+	unsigned shift = offset / HALF_SUB_BUCKET_COUNT + 1;
+	uint64_t top = offset % HALF_SUB_BUCKET_COUNT + HALF_SUB_BUCKET_COUNT;
+
+	return ((top + 1) << shift) - 1;
+}
@@ -0,0 +1,120 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @return the current time stamp counter, in ticks of get_ns_per_tick
+ *         nanoseconds; a steady clock in nanoseconds where there is no TSC
+ */
+inline uint64_t read_timestamp_counter() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+	// keep earlier instructions from drifting past the read
+	_mm_lfence();
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @return nanoseconds per tick of read_timestamp_counter, measured against
+ *         the steady clock on the first call
+ */
+double get_ns_per_tick();
+
+/**
+ * Log-linear histogram of latencies, in the style of HdrHistogram: values
+ * below 2^SUB_BUCKET_BITS get a bucket each, and every larger power of two is
+ * split into 2^(SUB_BUCKET_BITS - 1) equal buckets, so any value is known to
+ * within 1 / 2^(SUB_BUCKET_BITS - 1) of itself. Buckets are only allocated up
+ * to the largest value recorded.
+ */
+class LatencyHistogram
+{
+public:
+	static constexpr unsigned SUB_BUCKET_BITS = 8;
+
+	void record(uint64_t value)
+	{
+		size_t index = getIndex(value);
+		if (index >= _counts.size())
+		{
+			_counts.resize(index + 1);
+		}
+
+		++_counts[index];
+		++_count;
+		_max = value > _max ? value : _max;
+	}
+
+	/**
+	 * Adds the values recorded by another histogram.
+	 *
+	 * @param other histogram to add
+	 */
+	void merge(const LatencyHistogram& other);
+
+	uint64_t getCount() const noexcept
+	{
+		return _count;
+	}
+
+	uint64_t getMax() const noexcept
+	{
+		return _max;
+	}
+
+	/**
+	 * @param  quantile quantile within [0, 1], e.g. 0.999
+	 * @return          the largest value in the bucket holding the quantile,
+	 *                  capped at the maximum, or 0 if nothing was recorded
+	 */
+	uint64_t getQuantile(double quantile) const noexcept;
+
+	/**
+	 * Writes the nonzero buckets as text, for load to pick up later.
+	 */
+	void save(std::ostream& out) const;
+
+	/**
+	 * Replaces the recorded values with those written by save.
+	 */
+	void load(std::istream& in);
+
+private:
+	static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+	static constexpr uint64_t HALF_SUB_BUCKET_COUNT = SUB_BUCKET_COUNT / 2;
+
+	std::vector<uint64_t> _counts;
+	uint64_t _count = 0;
+	uint64_t _max = 0;
+
+	static size_t getIndex(uint64_t value) noexcept
+	{
+		if (value < SUB_BUCKET_COUNT)
+		{
+			return value;
+		}
+
+		// keep the top SUB_BUCKET_BITS bits of the value
+		unsigned shift = std::bit_width(value) - SUB_BUCKET_BITS;
+		return SUB_BUCKET_COUNT + (shift - 1) * HALF_SUB_BUCKET_COUNT + ((value >> shift) - HALF_SUB_BUCKET_COUNT);
+	}
+
+	/**
+	 * @return the largest value that falls in a bucket
+	 */
+	static uint64_t getBucketMax(size_t index) noexcept;
+};
+
+#endif
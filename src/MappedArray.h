@@ -0,0 +1,413 @@
+#ifndef MAPPEDARRAY_H
+#define MAPPEDARRAY_H
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// access pattern hints for mapped memory, passed on to madvise
+enum class MappingAdvice
+{
+	Normal = MADV_NORMAL,
+	Random = MADV_RANDOM,
+	Sequential = MADV_SEQUENTIAL,
+	WillNeed = MADV_WILLNEED,
+	DontNeed = MADV_DONTNEED
+};
+
+/**
+ * A std::vector replacement for trivially copyable elements whose contents can
+ * live in one of three places:
+ *  - the heap, growing with realloc exactly like a vector would
+ *  - a private, copy-on-write mapping of a file region (see mapFile), whose
+ *    writes are never written back to the file
+ *  - a shared mapping of a growable file (see createFile and openFile), which
+ *    lets the OS page cold elements out instead of holding them all in RAM
+ *
+ * Mapping a file costs the same regardless of its size, since pages are only
+ * faulted in when touched.
+ */
+template <typename T>
+class MappedArray
+{
+	static_assert(std::is_trivially_copyable_v<T>, "MappedArray elements must be trivially copyable");
+
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	enum class Backing
+	{
+		Heap,
+		PrivateMapping,
+		SharedFile
+	};
+
+	MappedArray() = default;
+
+	MappedArray(const MappedArray& other)
+	{
+		reserve(other._size);
+		std::memcpy(_data, other._data, other._size * sizeof(T));
+		_size = other._size;
+	}
+
+	MappedArray(MappedArray&& other) noexcept
+	{
+		swap(other);
+	}
+
+	MappedArray& operator=(MappedArray other) noexcept
+	{
+		swap(other);
+		return *this;
+	}
+
+	~MappedArray()
+	{
+		release();
+	}
+
+	void swap(MappedArray& other) noexcept
+	{
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+		std::swap(_capacity, other._capacity);
+		std::swap(_backing, other._backing);
+		std::swap(_mappedBytes, other._mappedBytes);
+		std::swap(_file, other._file);
+		std::swap(_fileOffset, other._fileOffset);
+	}
+
+	/**
+	 * Replaces the contents with a copy-on-write mapping of count elements
+	 * stored in a file at a page-aligned offset. Address space is reserved for
+	 * capacity elements, so appending up to that many never copies.
+	 *
+	 * @param path     file to map
+	 * @param offset   byte offset of the first element, a multiple of the page size
+	 * @param count    number of elements stored in the file
+	 * @param capacity number of elements to reserve address space for
+	 */
+	void mapFile(const std::string& path, size_t offset, size_t count, size_t capacity)
+	{
+		capacity = std::max(capacity, count);
+
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+		}
+
+		size_t reservedBytes = std::max<size_t>(capacity * sizeof(T), 1);
+		void* region = ::mmap(nullptr, reservedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (region == MAP_FAILED)
+		{
+			::close(fd);
+			throw std::runtime_error(std::string("Failed to reserve address space: ") + std::strerror(errno));
+		}
+
+		if (count > 0 && ::mmap(region, count * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, offset) == MAP_FAILED)
+		{
+			int error = errno;
+			::munmap(region, reservedBytes);
+			::close(fd);
+			throw std::runtime_error("Failed to map " + path + ": " + std::strerror(error));
+		}
+
+		// the mapping keeps its own reference to the file
+		::close(fd);
+
+		release();
+		_data = static_cast<T*>(region);
+		_size = count;
+		_capacity = capacity;
+		_backing = Backing::PrivateMapping;
+		_mappedBytes = reservedBytes;
+	}
+
+	/**
+	 * Moves the elements into a newly created file, starting at offset, and
+	 * keeps them there. The file grows along with the array, and changes are
+	 * written back to it by the OS or by flush. The first offset bytes of the
+	 * file are left for the caller, see getFileHeader.
+	 *
+	 * @param path   file to create or overwrite
+	 * @param offset byte offset of the first element, a multiple of the page size
+	 */
+	void createFile(const std::string& path, size_t offset)
+	{
+		size_t capacity = std::max<size_t>(_capacity, 1);
+		MappedFile file(path, MappedFile::Mode::Create, offset + capacity * sizeof(T));
+		std::memcpy(static_cast<char*>(file.getData()) + offset, _data, _size * sizeof(T));
+
+		size_t size = _size;
+		release();
+		attachFile(std::move(file), offset, size);
+	}
+
+	/**
+	 * Replaces the contents with the count elements stored at offset in a file
+	 * previously set up by createFile, keeping them in that file.
+	 *
+	 * @param path   file to open read-write
+	 * @param offset byte offset of the first element
+	 * @param count  number of elements stored in the file
+	 */
+	void openFile(const std::string& path, size_t offset, size_t count)
+	{
+		MappedFile file(path, MappedFile::Mode::ReadWrite);
+		if (file.getSize() < offset + count * sizeof(T))
+		{
+			throw std::runtime_error(path + " is smaller than its recorded size");
+		}
+
+		release();
+		attachFile(std::move(file), offset, count);
+	}
+
+	/**
+	 * @return the bytes before the first element of a shared file, or nullptr
+	 *         when the elements aren't kept in a file
+	 */
+	void* getFileHeader() noexcept
+	{
+		return _backing == Backing::SharedFile ? _file.getData() : nullptr;
+	}
+
+	Backing getBacking() const noexcept
+	{
+		return _backing;
+	}
+
+	/**
+	 * Hints how the elements are about to be accessed. Only mapped arrays are
+	 * advised; heap memory is left to the allocator.
+	 *
+	 * DontNeed drops the pages of a private mapping along with every change
+	 * made to them, so it is only allowed for shared files, whose dirty pages
+	 * are written back first.
+	 *
+	 * @param advice expected access pattern
+	 * @throws       std::invalid_argument for DontNeed on a private mapping
+	 */
+	void advise(MappingAdvice advice)
+	{
+		void* region = _backing == Backing::SharedFile ? _file.getData() : _data;
+		size_t bytes = _backing == Backing::SharedFile ? _file.getSize() : _mappedBytes;
+
+		if (_backing == Backing::Heap || region == nullptr)
+		{
+			return;
+		}
+
+		if (advice == MappingAdvice::DontNeed)
+		{
+			if (_backing != Backing::SharedFile)
+			{
+				throw std::invalid_argument("DontNeed would discard the changes to a private mapping");
+			}
+
+			flush(true);
+		}
+
+		if (::madvise(region, bytes, static_cast<int>(advice)) == -1)
+		{
+			throw std::runtime_error(std::string("Failed to advise mapping: ") + std::strerror(errno));
+		}
+	}
+
+	/**
+	 * Writes dirty pages of a shared file back to disk. Does nothing for other
+	 * backings.
+	 *
+	 * @param wait block until the pages have been written
+	 */
+	void flush(bool wait = true)
+	{
+		if (_backing == Backing::SharedFile)
+		{
+			_file.sync(wait);
+		}
+	}
+
+	void reserve(size_t capacity)
+	{
+		if (capacity <= _capacity)
+		{
+			return;
+		}
+
+		if (_backing == Backing::SharedFile)
+		{
+			_file.resize(_fileOffset + capacity * sizeof(T));
+			_data = reinterpret_cast<T*>(static_cast<char*>(_file.getData()) + _fileOffset);
+		}
+		else if (_backing == Backing::PrivateMapping)
+		{
+			// a partly file-backed region cannot be remapped, so move to the heap
+			T* data = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+			if (data == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+
+			std::memcpy(data, _data, _size * sizeof(T));
+			::munmap(_data, _mappedBytes);
+			_data = data;
+			_backing = Backing::Heap;
+			_mappedBytes = 0;
+		}
+		else
+		{
+			T* data = static_cast<T*>(std::realloc(_data, capacity * sizeof(T)));
+			if (data == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+
+			_data = data;
+		}
+
+		_capacity = capacity;
+	}
+
+	template <typename... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (_size == _capacity)
+		{
+			reserve(std::max<size_t>(16, _capacity * 2));
+		}
+
+		return *new (_data + _size++) T(std::forward<Args>(args)...);
+	}
+
+	void push_back(const T& value)
+	{
+		emplace_back(value);
+	}
+
+	void pop_back() noexcept
+	{
+		--_size;
+	}
+
+	void clear() noexcept
+	{
+		_size = 0;
+	}
+
+	T& operator[](size_t index) noexcept
+	{
+		return _data[index];
+	}
+
+	const T& operator[](size_t index) const noexcept
+	{
+		return _data[index];
+	}
+
+	T* data() noexcept
+	{
+		return _data;
+	}
+
+	const T* data() const noexcept
+	{
+		return _data;
+	}
+
+	size_t size() const noexcept
+	{
+		return _size;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return _capacity;
+	}
+
+	bool empty() const noexcept
+	{
+		return _size == 0;
+	}
+
+	iterator begin() noexcept
+	{
+		return _data;
+	}
+
+	iterator end() noexcept
+	{
+		return _data + _size;
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return _data;
+	}
+
+	const_iterator end() const noexcept
+	{
+		return _data + _size;
+	}
+
+private:
+	T* _data = nullptr;
+	size_t _size = 0;
+	size_t _capacity = 0;
+	Backing _backing = Backing::Heap;
+	// size of the reserved region of a private mapping
+	size_t _mappedBytes = 0;
+	MappedFile _file;
+	size_t _fileOffset = 0;
+
+	void attachFile(MappedFile&& file, size_t offset, size_t size)
+	{
+		_file = std::move(file);
+		_fileOffset = offset;
+		_data = reinterpret_cast<T*>(static_cast<char*>(_file.getData()) + offset);
+		_size = size;
+		_capacity = (_file.getSize() - offset) / sizeof(T);
+		_backing = Backing::SharedFile;
+	}
+
+	void release() noexcept
+	{
+		if (_backing == Backing::PrivateMapping)
+		{
+			::munmap(_data, _mappedBytes);
+		}
+		else if (_backing == Backing::SharedFile)
+		{
+			_file.close();
+		}
+		else
+		{
+			std::free(_data);
+		}
+
+		_data = nullptr;
+		_size = 0;
+		_capacity = 0;
+		_backing = Backing::Heap;
+		_mappedBytes = 0;
+		_fileOffset = 0;
+	}
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	[[noreturn]] void throw_errno(const std::string& what)
+	{
+		throw std::runtime_error(what + ": " + std::strerror(errno));
+	}
+}
+
+MappedFile::MappedFile(const std::string& path, Mode mode, size_t size): _mode(mode)
+{
+	int flags = O_RDONLY;
+	if (mode == Mode::ReadWrite)
+	{
+		flags = O_RDWR;
+	}
+	else if (mode == Mode::Create)
+	{
+		flags = O_RDWR | O_CREAT | O_TRUNC;
+	}
+
+	_fd = ::open(path.c_str(), flags, 0644);
+	if (_fd == -1)
+	{
+		throw_errno("Failed to open " + path);
+	}
+
+	if (mode == Mode::Create)
+	{
+		if (::ftruncate(_fd, size) == -1)
+		{
+			::close(_fd);
+			throw_errno("Failed to size " + path);
+		}
+		_size = size;
+	}
+	else
+	{
+		struct stat st;
+		if (::fstat(_fd, &st) == -1)
+		{
+			::close(_fd);
+			throw_errno("Failed to stat " + path);
+		}
+		_size = st.st_size;
+	}
+
+	try
+	{
+		map();
+	}
+	catch (...)
+	{
+		::close(_fd);
+		throw;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: _fd(std::exchange(other._fd, -1)), _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)), _mode(other._mode)
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		_fd = std::exchange(other._fd, -1);
+		_data = std::exchange(other._data, nullptr);
+		_size = std::exchange(other._size, 0);
+		_mode = other._mode;
+	}
+
+	return *this;
+}
+
+void MappedFile::map()
+{
+	if (_size == 0)
+	{
+		_data = nullptr;
+		return;
+	}
+
+	int prot = _mode == Mode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+	int flags = _mode == Mode::CopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+
+	_data = ::mmap(nullptr, _size, prot, flags, _fd, 0);
+	if (_data == MAP_FAILED)
+	{
+		_data = nullptr;
+		throw_errno("Failed to map file");
+	}
+}
+
+void MappedFile::unmap() noexcept
+{
+	if (_data != nullptr)
+	{
+		::munmap(_data, _size);
+		_data = nullptr;
+	}
+}
+
+void MappedFile::resize(size_t size)
+{
+	if (_mode == Mode::ReadOnly || _mode == Mode::CopyOnWrite)
+	{
+		throw std::logic_error("Cannot resize a read-only or copy-on-write mapping");
+	}
+
+	if (::ftruncate(_fd, size) == -1)
+	{
+		throw_errno("Failed to resize file");
+	}
+
+	if (_data == nullptr || size == 0)
+	{
+		unmap();
+		_size = size;
+		map();
+		return;
+	}
+
+	void* data = ::mremap(_data, _size, size, MREMAP_MAYMOVE);
+	if (data == MAP_FAILED)
+	{
+		throw_errno("Failed to remap file");
+	}
+
+	_data = data;
+	_size = size;
+}
+
+void MappedFile::sync(bool wait)
+{
+	if (_data == nullptr || _mode == Mode::ReadOnly || _mode == Mode::CopyOnWrite)
+	{
+		return;
+	}
+
+	if (::msync(_data, _size, wait ? MS_SYNC : MS_ASYNC) == -1)
+	{
+		throw_errno("Failed to sync file");
+	}
+}
+
+void MappedFile::close() noexcept
+{
+	if (_fd == -1)
+	{
+		return;
+	}
+
+	if (_data != nullptr && (_mode == Mode::ReadWrite || _mode == Mode::Create))
+	{
+		::msync(_data, _size, MS_SYNC);
+	}
+
+	unmap();
+	::close(_fd);
+	_fd = -1;
+	_size = 0;
+}
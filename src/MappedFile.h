@@ -0,0 +1,89 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * RAII wrapper around a memory-mapped file. Pages are faulted in lazily by the
+ * OS, so mapping a file costs the same regardless of its size.
+ *
+ * Failures to open, size or map the file throw std::runtime_error.
+ */
+class MappedFile
+{
+public:
+	enum class Mode
+	{
+		// map an existing file read-only
+		ReadOnly,
+		// map an existing file privately; writes are never written back
+		CopyOnWrite,
+		// map an existing file, writing changes back to it
+		ReadWrite,
+		// create or truncate a file to the given size, then map it read-write
+		Create
+	};
+
+	MappedFile() = default;
+
+	/**
+	 * @param path file to map
+	 * @param mode how to open and map the file
+	 * @param size file size in bytes, only used with Mode::Create
+	 */
+	MappedFile(const std::string& path, Mode mode, size_t size = 0);
+	~MappedFile();
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	void* getData() const noexcept
+	{
+		return _data;
+	}
+
+	size_t getSize() const noexcept
+	{
+		return _size;
+	}
+
+	bool isOpen() const noexcept
+	{
+		return _fd != -1;
+	}
+
+	/**
+	 * Grows or shrinks the file and its mapping. The mapping may move, so any
+	 * pointers into it are invalidated. Not allowed in read-only mode.
+	 *
+	 * @param size new file size in bytes
+	 */
+	void resize(size_t size);
+
+	/**
+	 * Writes dirty pages of a shared mapping back to the file.
+	 *
+	 * @param wait block until the pages have been written
+	 */
+	void sync(bool wait = true);
+
+	/**
+	 * Syncs a writable shared mapping, then unmaps and closes the file.
+	 */
+	void close() noexcept;
+
+private:
+	int _fd = -1;
+	void* _data = nullptr;
+	size_t _size = 0;
+	Mode _mode = Mode::ReadOnly;
+
+	void map();
+	void unmap() noexcept;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bytes a tree holds, by what they hold. The node fields and padding add up to
+ * the nodes themselves; slack is what the allocator adds around them, and
+ * headroom is capacity reserved for nodes that don't exist yet.
+ */
+struct MemoryUsage
+{
+	uint64_t keys = 0;
+	// whole rank structs, including their comparison counter pointers
+	uint64_t ranks = 0;
+	// child pointers or indices
+	uint64_t links = 0;
+	// alignment padding inside the nodes
+	uint64_t padding = 0;
+	// allocator headers and rounding, or the unused end of the last page
+	uint64_t allocatorSlack = 0;
+	// capacity reserved beyond the current nodes; for mapped storage this is
+	// address space, which only takes memory once it is touched
+	uint64_t capacityHeadroom = 0;
+
+	/**
+	 * @return bytes of the nodes and the allocator slack around them
+	 */
+	uint64_t getUsed() const noexcept
+	{
+		return keys + ranks + links + padding + allocatorSlack;
+	}
+
+	uint64_t getTotal() const noexcept
+	{
+		return getUsed() + capacityHeadroom;
+	}
+
+	/**
+	 * Fills in the node fields of count nodes of a given layout.
+	 *
+	 * @param count    number of nodes
+	 * @param nodeSize size of a node
+	 * @param keySize  size of the key within a node
+	 * @param rankSize size of the rank within a node
+	 * @param linkSize size of both child links within a node
+	 */
+	void addNodes(uint64_t count, size_t nodeSize, size_t keySize, size_t rankSize, size_t linkSize) noexcept
+	{
+		keys += count * keySize;
+		ranks += count * rankSize;
+		links += count * linkSize;
+		padding += count * (nodeSize - keySize - rankSize - linkSize);
+	}
+};
+
+/**
+ * @param  size bytes requested from malloc
+ * @return      bytes a chunk of that size takes in glibc's malloc with its
+ *              default thresholds: the size plus an 8 byte header, rounded up
+ *              to 16 bytes and at least 32, or for blocks of 128 KiB and up,
+ *              which get their own mapping, a 16 byte header rounded up to 4
+ *              KiB pages
+ */
+constexpr size_t get_malloc_chunk_size(size_t size) noexcept
+{
+	if (size + 8 >= 128 * 1024)
+	{
+		return (size + 16 + 4095) & ~size_t(4095);
+	}
+
+	return std::max<size_t>((size + 8 + 15) & ~size_t(15), 32);
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include "PSweep.h"
+
+#include "ShapeSimulator.h"
+#include "ZipTreeVariableP.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+	struct TrialResult
+	{
+		ShapeStatistics shape;
+		uint64_t ns;
+	};
+
+	TrialResult run_simulated_trial(uint64_t n, double p)
+	{
+		// an empty tree only serves as the rank distribution
+		ZipTreeVariableP<unsigned> ranks(0, p);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		ShapeStatistics shape = simulate_shape<GeometricRank>(n, [&ranks] { return ranks.sampleRank(); });
+		auto end = std::chrono::high_resolution_clock::now();
+
+		return {shape, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count())};
+	}
+}
+
+std::vector<double> make_linear_grid(double low, double high, unsigned count)
+{
+	std::vector<double> grid;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		grid.push_back(count > 1 ? low + (high - low) * i / (count - 1) : low);
+	}
+
+	return grid;
+}
+
+std::vector<double> make_log_grid(double low, double high, unsigned count)
+{
+	std::vector<double> grid;
+	for (double exponent : make_linear_grid(std::log(low), std::log(high), count))
+	{
+		grid.push_back(std::exp(exponent));
+	}
+
+	// keep the bounds exact rather than round trips through log and exp
+	if (!grid.empty())
+	{
+		grid.front() = low;
+		grid.back() = high;
+	}
+
+	return grid;
+}
+
+PSweep::PSweep(const PSweepOptions& options)
+	: _options(options), _pool(options.numThreads), _aggregator(options.summaryPath, "n,p", options.flushInterval)
+{
+}
+
+void PSweep::run(const std::vector<double>& ps)
+{
+	std::vector<std::pair<double, std::future<TrialResult>>> results;
+
+	for (double p : ps)
+	{
+		if (std::binary_search(_ps.begin(), _ps.end(), p))
+		{
+			continue;
+		}
+
+		_ps.insert(std::upper_bound(_ps.begin(), _ps.end(), p), p);
+
+		for (unsigned trial = 0; trial < _options.numTrials; ++trial)
+		{
+			results.emplace_back(p, _pool.submit([n = _options.n, p] { return run_simulated_trial(n, p); }));
+		}
+	}
+
+	for (auto& [p, future] : results)
+	{
+		TrialResult result = future.get();
+		const ShapeStatistics& shape = result.shape;
+		std::string group = getGroup(p);
+
+		_aggregator.add(group, "ns", result.ns);
+		_aggregator.add(group, "height", shape.height);
+		_aggregator.add(group, "avg_depth", shape.getAverageDepth());
+		_aggregator.add(group, "min_depth", shape.minKeyDepth);
+		_aggregator.add(group, "median_depth", shape.medianKeyDepth);
+		_aggregator.add(group, "max_depth", shape.maxKeyDepth);
+		_aggregator.add(group, "root_rank", shape.rootRank);
+		_aggregator.flushIfDue();
+	}
+}
+
+std::vector<double> PSweep::refine(unsigned count) const
+{
+	std::vector<double> means;
+	for (double p : _ps)
+	{
+		const MetricSummary* summary = find(p, _options.refinementMetric);
+		means.push_back(summary != nullptr ? summary->statistics.getMean() : std::numeric_limits<double>::quiet_NaN());
+	}
+
+	if (means.size() < 2)
+	{
+		return {};
+	}
+
+	size_t best = std::min_element(means.begin(), means.end()) - means.begin();
+
+	// interval i lies between _ps[i] and _ps[i + 1]
+	std::vector<std::pair<double, size_t>> intervals;
+	for (size_t i = 0; i + 1 < means.size(); ++i)
+	{
+		bool isAroundBest = i == best || i + 1 == best;
+		double score = isAroundBest ? std::numeric_limits<double>::infinity() : std::abs(means[i + 1] - means[i]);
+		intervals.emplace_back(score, i);
+	}
+
+	std::sort(intervals.begin(), intervals.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	std::vector<double> ps;
+	for (const auto& [score, i] : intervals)
+	{
+		if (ps.size() == count)
+		{
+			break;
+		}
+
+		double p = std::sqrt(_ps[i] * _ps[i + 1]);
+		if (p > _ps[i] && p < _ps[i + 1])
+		{
+			ps.push_back(p);
+		}
+	}
+
+	return ps;
+}
+
+const MetricSummary* PSweep::find(double p, const std::string& metric) const
+{
+	return _aggregator.find(getGroup(p), metric);
+}
+
+void PSweep::flush()
+{
+	_aggregator.flush();
+}
+
+std::string PSweep::getGroup(double p) const
+{
+	std::ostringstream group;
+	group.precision(std::numeric_limits<double>::max_digits10);
+	group << _options.n << "," << p;
+	return group.str();
+}
@@ -0,0 +1,101 @@
+#ifndef PSWEEP_H
+#define PSWEEP_H
+
+#include "StreamingStatistics.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @return count values evenly spaced over [low, high]
+ */
+std::vector<double> make_linear_grid(double low, double high, unsigned count);
+
+/**
+ * @return count values evenly spaced over [low, high] on a log scale; both
+ *         bounds must be positive
+ */
+std::vector<double> make_log_grid(double low, double high, unsigned count);
+
+struct PSweepOptions
+{
+	// keys per simulated tree
+	uint64_t n = 1 << 20;
+	unsigned numTrials = 100;
+	// run-phase metric whose changes refine follows: height, avg_depth,
+	// min_depth, median_depth, max_depth or root_rank
+	std::string refinementMetric = "avg_depth";
+	// worker threads, 0 for every hardware thread
+	unsigned numThreads = 0;
+	std::string summaryPath = "p-sweep.csv";
+	std::chrono::milliseconds flushInterval = std::chrono::seconds(10);
+};
+
+/**
+ * Sweeps the p of ZipTreeVariableP over a grid. Every (p, trial) pair is an
+ * independent task on a thread pool that streams geometric ranks through a
+ * ShapeSimulator instead of building a tree, and the shape of each trial is
+ * folded into per-p streaming aggregates as results arrive, in the order the
+ * tasks were submitted. The aggregates are written to a summary CSV with one
+ * row per (n, p, metric), like StatisticsAggregator.
+ *
+ * Grids can be swept in rounds: refine proposes new p values where the swept
+ * ones show the metric changing most, and around its minimum.
+ */
+class PSweep
+{
+public:
+	explicit PSweep(const PSweepOptions& options);
+
+	/**
+	 * Runs the trials of every p not swept yet and waits for them.
+	 *
+	 * @param ps p values to sweep, each within (0, 1)
+	 */
+	void run(const std::vector<double>& ps);
+
+	/**
+	 * Proposes p values between adjacent swept ones: the intervals on both
+	 * sides of the smallest mean of the refinement metric come first, then
+	 * those across which its mean changes most. Each proposal is the
+	 * geometric mean of its interval, so log-spaced grids stay log-spaced.
+	 *
+	 * @param  count largest number of p values to propose
+	 * @return       new p values, ready to pass to run
+	 */
+	std::vector<double> refine(unsigned count) const;
+
+	/**
+	 * @return the summary of a metric for a swept p, or nullptr
+	 */
+	const MetricSummary* find(double p, const std::string& metric) const;
+
+	/**
+	 * @return the swept p values, in increasing order
+	 */
+	const std::vector<double>& getPs() const noexcept
+	{
+		return _ps;
+	}
+
+	/**
+	 * Writes the summary of every swept p.
+	 */
+	void flush();
+
+private:
+	PSweepOptions _options;
+	ThreadPool _pool;
+	StatisticsAggregator _aggregator;
+	std::vector<double> _ps;
+
+	/**
+	 * @return the CSV group fields of a p, matching the "n,p" header
+	 */
+	std::string getGroup(double p) const;
+};
+
+#endif
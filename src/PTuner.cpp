@@ -0,0 +1,139 @@
+#include "PTuner.h"
+
+#include <algorithm>
+#include <chrono>
+
+PTuner::PTuner(const PTunerOptions& options): _options(options)
+{
+}
+
+void PTuner::record(const Operation& operation)
+{
+	if (_options.sampleSize == 0)
+	{
+		return;
+	}
+
+	if (_sample.size() < _options.sampleSize)
+	{
+		_sample.push_back(operation);
+	}
+	else
+	{
+		_sample[_nextSample] = operation;
+	}
+
+	_nextSample = (_nextSample + 1) % _options.sampleSize;
+}
+
+std::vector<Operation> PTuner::getSample() const
+{
+	if (_sample.size() < _options.sampleSize)
+	{
+		return _sample;
+	}
+
+	std::vector<Operation> sample(_sample.begin() + _nextSample, _sample.end());
+	sample.insert(sample.end(), _sample.begin(), _sample.begin() + _nextSample);
+	return sample;
+}
+
+std::vector<PCost> PTuner::profile(const std::vector<unsigned>& loadKeys, const std::vector<Operation>& trace) const
+{
+	std::vector<PCost> costs;
+	for (double p : _options.candidates)
+	{
+		costs.push_back({p, measure(p, loadKeys, trace)});
+	}
+
+	return costs;
+}
+
+double PTuner::tune(ZipTreeVariableP<unsigned>& tree) const
+{
+	std::vector<Operation> trace = getSample();
+	if (trace.empty())
+	{
+		return tree.getP();
+	}
+
+	std::vector<unsigned> keys;
+	keys.reserve(tree.getSize());
+	tree.depthProfile([&keys](unsigned key, unsigned, uint64_t) { keys.push_back(key); });
+
+	PCost cheapest = getCheapest(profile(keys, trace));
+	double currentCost = measure(tree.getP(), keys, trace);
+
+	if (cheapest.p != tree.getP() && cheapest.nsPerOperation <= currentCost * (1 - _options.minImprovement))
+	{
+		tree.rebuild(cheapest.p);
+	}
+
+	return tree.getP();
+}
+
+PCost PTuner::getCheapest(const std::vector<PCost>& costs) noexcept
+{
+	auto cheapest = std::min_element(costs.begin(), costs.end(), [](const PCost& a, const PCost& b) { return a.nsPerOperation < b.nsPerOperation; });
+	return cheapest != costs.end() ? *cheapest : PCost{0, 0};
+}
+
+double PTuner::measure(double p, const std::vector<unsigned>& loadKeys, const std::vector<Operation>& trace) const
+{
+	uint64_t totalNs = 0;
+	unsigned numRepetitions = std::max(_options.numRepetitions, 1u);
+
+	for (unsigned repetition = 0; repetition < numRepetitions; ++repetition)
+	{
+		// replays may insert every key of the trace
+		ZipTreeVariableP<unsigned> tree(loadKeys.size() + trace.size(), p);
+		for (unsigned key : loadKeys)
+		{
+			if (!tree.find(key))
+			{
+				tree.insert(key);
+			}
+		}
+
+		unsigned hits = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const auto& operation : trace)
+		{
+			switch (operation.type)
+			{
+			case OperationType::Insert:
+				if (!tree.find(operation.key))
+				{
+					tree.insert(operation.key);
+					++hits;
+				}
+				break;
+
+			case OperationType::Find:
+				hits += tree.find(operation.key);
+				break;
+
+			case OperationType::Remove:
+				hits += tree.remove(operation.key);
+				break;
+
+			case OperationType::Range:
+			{
+				unsigned high = operation.key + std::min(_options.rangeWidth - 1, ~operation.key);
+				hits += tree.countRange(operation.key, high);
+				break;
+			}
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		// keeps the replay from being optimized away
+		[[maybe_unused]] static volatile unsigned sink;
+		sink = hits;
+
+		totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+
+	return trace.empty() ? 0 : static_cast<double>(totalNs) / numRepetitions / trace.size();
+}
@@ -0,0 +1,97 @@
+#ifndef PTUNER_H
+#define PTUNER_H
+
+#include "Workload.h"
+#include "ZipTreeVariableP.h"
+
+#include <cstddef>
+#include <vector>
+
+struct PTunerOptions
+{
+	// p values to profile, each within (0, 1)
+	std::vector<double> candidates = {0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8};
+	// operations kept by the live sample
+	unsigned sampleSize = 1 << 16;
+	// replays of the trace per candidate, each on a tree with fresh ranks
+	unsigned numRepetitions = 3;
+	// number of consecutive keys a range operation spans
+	unsigned rangeWidth = 64;
+	// smallest fraction of the current cost per operation that the best
+	// candidate must save before tune rebuilds the tree
+	double minImprovement = 0.05;
+};
+
+struct PCost
+{
+	double p;
+	double nsPerOperation;
+};
+
+/**
+ * Picks the p of a ZipTreeVariableP by measurement. Each candidate p gets a
+ * tree loaded with the same keys, on which an operation trace is replayed and
+ * timed; the p with the lowest mean cost per operation wins. The trace is
+ * either given, e.g. a representative Workload, or a live sample of the most
+ * recent operations passed to record, against which tune re-profiles a tree's
+ * current keys and rebuilds it with the winning p when the workload has
+ * shifted far enough from the one its p was picked for.
+ *
+ * Replays run on fresh trees, so profiling never changes the tuned tree, but
+ * they take about numRepetitions times the trace per candidate.
+ */
+class PTuner
+{
+public:
+	explicit PTuner(const PTunerOptions& options = PTunerOptions());
+
+	/**
+	 * Adds an operation to the live sample, dropping the oldest one once the
+	 * sample is full.
+	 *
+	 * @param operation operation just performed on the tuned tree
+	 */
+	void record(const Operation& operation);
+
+	/**
+	 * @return the live sample, oldest operation first
+	 */
+	std::vector<Operation> getSample() const;
+
+	/**
+	 * Times a trace for every candidate p.
+	 *
+	 * @param  loadKeys keys inserted, untimed, before the trace is replayed;
+	 *                  repeated keys are inserted once
+	 * @param  trace    operations to time
+	 * @return          cost of each candidate, in the order of the candidates
+	 */
+	std::vector<PCost> profile(const std::vector<unsigned>& loadKeys, const std::vector<Operation>& trace) const;
+
+	/**
+	 * Profiles the live sample on a tree's current keys, against the
+	 * candidates and the tree's own p, and rebuilds the tree with the cheapest
+	 * p if that saves at least minImprovement of the current cost. Does
+	 * nothing while the sample is empty.
+	 *
+	 * @param  tree tree to tune
+	 * @return      p of the tree afterwards
+	 */
+	double tune(ZipTreeVariableP<unsigned>& tree) const;
+
+	/**
+	 * @param  costs costs returned by profile
+	 * @return       the cheapest of them
+	 */
+	static PCost getCheapest(const std::vector<PCost>& costs) noexcept;
+
+private:
+	PTunerOptions _options;
+	// ring buffer of the live sample; _nextSample is the slot written next
+	std::vector<Operation> _sample;
+	size_t _nextSample = 0;
+
+	double measure(double p, const std::vector<unsigned>& loadKeys, const std::vector<Operation>& trace) const;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "PerfCounters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace
+{
+	struct EventDescription
+	{
+		const char* name;
+		uint32_t type;
+		uint64_t config;
+	};
+
+	constexpr uint64_t get_cache_read_miss(uint64_t cache) noexcept
+	{
+		return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+
+	// in the order of PerfCounts::Event
+	constexpr EventDescription EVENTS[PerfCounts::NUM_EVENTS] = {
+		{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{"l1d_misses", PERF_TYPE_HW_CACHE, get_cache_read_miss(PERF_COUNT_HW_CACHE_L1D)},
+		{"llc_misses", PERF_TYPE_HW_CACHE, get_cache_read_miss(PERF_COUNT_HW_CACHE_LL)},
+		{"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+		{"dtlb_misses", PERF_TYPE_HW_CACHE, get_cache_read_miss(PERF_COUNT_HW_CACHE_DTLB)}
+	};
+
+	int open_counter(const EventDescription& event) noexcept
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = event.type;
+		attr.config = event.config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		// this thread, on any CPU
+		return ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+}
+
+const char* PerfCounts::getName(Event event) noexcept
+{
+	return EVENTS[event].name;
+}
+
+PerfCounters::PerfCounters(): _available(0)
+{
+	for (unsigned i = 0; i < PerfCounts::NUM_EVENTS; ++i)
+	{
+		_fds[i] = open_counter(EVENTS[i]);
+		if (_fds[i] != -1)
+		{
+			_available |= 1u << i;
+		}
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	for (int fd : _fds)
+	{
+		if (fd != -1)
+		{
+			::close(fd);
+		}
+	}
+}
+
+void PerfCounters::start() noexcept
+{
+	for (int fd : _fds)
+	{
+		if (fd != -1)
+		{
+			::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+PerfCounts PerfCounters::stop() noexcept
+{
+	for (int fd : _fds)
+	{
+		if (fd != -1)
+		{
+			::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	PerfCounts counts;
+
+	for (unsigned i = 0; i < PerfCounts::NUM_EVENTS; ++i)
+	{
+		// value, time enabled, time running
+		uint64_t data[3];
+		if (_fds[i] == -1 || ::read(_fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+		{
+			continue;
+		}
+
+		counts.values[i] = data[2] < data[1] ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+		counts.available |= 1u << i;
+	}
+
+	return counts;
+}
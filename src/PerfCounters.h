@@ -0,0 +1,86 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+
+/**
+ * Values of the hardware events counted by PerfCounters over one interval.
+ */
+struct PerfCounts
+{
+	enum Event : unsigned
+	{
+		Cycles,
+		Instructions,
+		L1DMisses,
+		LLCMisses,
+		BranchMisses,
+		DTLBMisses,
+		NUM_EVENTS
+	};
+
+	uint64_t values[NUM_EVENTS] = {};
+	// bit e is set if event e was counted
+	unsigned available = 0;
+
+	bool isAvailable(Event event) const noexcept
+	{
+		return available & (1u << event);
+	}
+
+	/**
+	 * @return CSV-friendly name of an event, e.g. "llc_misses"
+	 */
+	static const char* getName(Event event) noexcept;
+};
+
+/**
+ * Hardware performance counters of the calling thread, read through
+ * perf_event_open. Only user-space events are counted, which most systems
+ * allow without privileges. Events the CPU, kernel or container does not
+ * provide are left out, so an object whose counters all failed to open is
+ * still safe to use and just reports nothing.
+ *
+ * Each event has its own counter, so the kernel may multiplex them when there
+ * are fewer hardware counters than events; the values are scaled by the
+ * fraction of the interval each counter ran.
+ */
+class PerfCounters
+{
+public:
+	/**
+	 * Opens the counters for the calling thread, stopped. Only that thread is
+	 * counted, so start and stop should be called from it.
+	 */
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	/**
+	 * @return mask of the events that could be opened, as in PerfCounts
+	 */
+	unsigned getAvailable() const noexcept
+	{
+		return _available;
+	}
+
+	/**
+	 * Resets the counters and starts counting.
+	 */
+	void start() noexcept;
+
+	/**
+	 * Stops counting.
+	 *
+	 * @return the events counted since start
+	 */
+	PerfCounts stop() noexcept;
+
+private:
+	int _fds[PerfCounts::NUM_EVENTS];
+	unsigned _available;
+};
+
+#endif
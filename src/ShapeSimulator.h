@@ -0,0 +1,173 @@
+#ifndef SHAPESIMULATOR_H
+#define SHAPESIMULATOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Shape of a zip tree of the keys 0, ..., n - 1, as measured by the
+ * experiments in test.cpp.
+ */
+struct ShapeStatistics
+{
+	uint64_t size = 0;
+	int height = -1;
+	uint64_t totalDepth = 0;
+	// depths of the smallest, median (n / 2) and largest keys
+	unsigned minKeyDepth = 0;
+	unsigned medianKeyDepth = 0;
+	unsigned maxKeyDepth = 0;
+	// rank value of the root, see the getValue member of the rank structs
+	uint64_t rootRank = 0;
+
+	double getAverageDepth() const noexcept
+	{
+		return static_cast<double>(totalDepth) / size;
+	}
+};
+
+/**
+ * Computes the shape of a zip tree from its ranks alone, without building it.
+ *
+ * The shape of a zip tree only depends on its keys and ranks: it is the
+ * Cartesian tree of the ranks in key order, where a larger rank is an
+ * ancestor and ties go to the smaller key. Feeding the ranks of the keys
+ * 0, ..., n - 1 in key order, the simulator keeps only the right spine of the
+ * tree built so far, as a stack. Each new key pops the spine nodes of smaller
+ * rank, which become its left subtree, and is pushed in their place.
+ *
+ * For every spine node the stack holds the size and height of the node and
+ * its left subtree, which are final once the node is pushed. A node's depth is
+ * the number of spine nodes below it when it is pushed (its ancestors with
+ * smaller keys) plus the number of later keys whose rank exceeds every rank
+ * since it (those with larger keys), so the sum of all depths is the sum of
+ * the former plus the sizes of all left subtrees.
+ *
+ * This takes O(n) time and O(height) memory, so trees far larger than memory
+ * can be measured.
+ */
+template <typename RankType>
+class ShapeSimulator
+{
+public:
+	/**
+	 * @param size number of keys that will be added
+	 */
+	explicit ShapeSimulator(uint64_t size): _numAdded(0), _totalDepth(0)
+	{
+		_watched[0].key = 0;
+		_watched[1].key = size / 2;
+	}
+
+	/**
+	 * Adds the next key in key order.
+	 *
+	 * @param rank rank of the key
+	 */
+	void add(const RankType& rank) noexcept
+	{
+		Entry entry = {rank, 1, 0};
+
+		// the popped nodes form the left subtree, chained along right children
+		int chainHeight = -1;
+		while (!_spine.empty() && _spine.back().rank < rank)
+		{
+			const Entry& top = _spine.back();
+			chainHeight = std::max<int>(top.height, chainHeight + 1);
+			entry.size += top.size;
+			_spine.pop_back();
+		}
+
+		entry.height = chainHeight + 1;
+		_totalDepth += _spine.size() + entry.size - 1;
+
+		for (auto& watched : _watched)
+		{
+			if (watched.key == _numAdded)
+			{
+				watched.depth = _spine.size();
+				watched.maxRank = rank;
+			}
+			else if (watched.key < _numAdded && watched.maxRank < rank)
+			{
+				// a new maximum since the watched key is one of its ancestors
+				++watched.depth;
+				watched.maxRank = rank;
+			}
+		}
+
+		_spine.push_back(entry);
+		++_numAdded;
+	}
+
+	/**
+	 * @return the shape of the tree of the keys added so far, which should be
+	 *         all of them for the key depths to be meaningful
+	 */
+	ShapeStatistics getStatistics() const noexcept
+	{
+		ShapeStatistics statistics;
+		statistics.size = _numAdded;
+		statistics.totalDepth = _totalDepth;
+
+		for (size_t i = 0; i < _spine.size(); ++i)
+		{
+			statistics.height = std::max<int>(statistics.height, i + _spine[i].height);
+		}
+
+		if (!_spine.empty())
+		{
+			statistics.minKeyDepth = _watched[0].depth;
+			statistics.medianKeyDepth = _watched[1].depth;
+			// the largest key is always the last node of the right spine
+			statistics.maxKeyDepth = _spine.size() - 1;
+			statistics.rootRank = _spine.front().rank.getValue();
+		}
+
+		return statistics;
+	}
+
+private:
+	struct Entry
+	{
+		RankType rank;
+		// size and height of the node and its left subtree
+		uint64_t size;
+		unsigned height;
+	};
+
+	// a key whose depth is tracked as later keys arrive
+	struct WatchedKey
+	{
+		uint64_t key;
+		unsigned depth = 0;
+		RankType maxRank;
+	};
+
+	uint64_t _numAdded;
+	uint64_t _totalDepth;
+	std::vector<Entry> _spine;
+	WatchedKey _watched[2];
+};
+
+/**
+ * Simulates the shape of a zip tree of the keys 0, ..., n - 1.
+ *
+ * @param  size       number of keys
+ * @param  sampleRank returns a new random rank on each call
+ * @return            the shape of the tree
+ */
+template <typename RankType, typename SampleRank>
+ShapeStatistics simulate_shape(uint64_t size, SampleRank&& sampleRank)
+{
+	ShapeSimulator<RankType> simulator(size);
+	for (uint64_t i = 0; i < size; ++i)
+	{
+		simulator.add(sampleRank());
+	}
+
+	return simulator.getStatistics();
+}
+
+#endif
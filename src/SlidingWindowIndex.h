@@ -0,0 +1,210 @@
+#ifndef SLIDINGWINDOWINDEX_H
+#define SLIDINGWINDOWINDEX_H
+
+#include <deque>
+#include <utility>
+
+/**
+ * Ordered index over a sliding window of keys, such as the timestamps of the
+ * last N events, built on any GeneralizedZipTree-based Tree (e.g.
+ * ZipTreeVariableP<uint64_t>). Keys enter at the maximum with pushBack and
+ * leave at the minimum with popFront, both in amortized constant time, while
+ * the window stays a zip tree for ordered queries.
+ *
+ * pushBack is the tree's fingerInsert on the right spine. popFront keeps a
+ * finger on the left spine: the minimum is its bottom node, which has no left
+ * child, so removing it only splices its right subtree into its parent, and
+ * the left spine of that subtree joins the finger. Every node joins the left
+ * spine at most once, when it becomes the new root or when the node above
+ * it is removed.
+ *
+ * Since keys arrive in increasing order, they also fill buckets in key order,
+ * so removed buckets are always a prefix of the bucket array. The prefix is
+ * reclaimed once it takes up half the array, by sliding the live buckets down
+ * and renumbering their links.
+ */
+template <typename Tree>
+class SlidingWindowIndex : protected Tree
+{
+public:
+	typedef typename Tree::key_type KeyType;
+
+	/**
+	 * @param treeArgs arguments of the Tree constructor, e.g. the largest
+	 *                 window size to reserve buckets for
+	 */
+	template <typename... TreeArgs>
+	explicit SlidingWindowIndex(TreeArgs&&... treeArgs): Tree(std::forward<TreeArgs>(treeArgs)...)
+	{
+	}
+
+	using Tree::find;
+	using Tree::fingerFind;
+	using Tree::countRange;
+	using Tree::forEachInRange;
+	using Tree::getDepth;
+	using Tree::getStatistics;
+	using Tree::memoryUsage;
+
+	int getHeight() const noexcept
+	{
+		return Tree::getHeight();
+	}
+
+	/**
+	 * @return number of keys in the window
+	 */
+	unsigned getSize() const noexcept
+	{
+		return this->_buckets.size() - _front;
+	}
+
+	bool empty() const noexcept
+	{
+		return getSize() == 0;
+	}
+
+	/**
+	 * @return smallest key in the window, which must not be empty
+	 */
+	const KeyType& front() const noexcept
+	{
+		return this->_buckets[_front].key;
+	}
+
+	/**
+	 * @return largest key in the window, which must not be empty
+	 */
+	const KeyType& back() const noexcept
+	{
+		return this->_buckets[this->_buckets.size() - 1].key;
+	}
+
+	/**
+	 * Adds a key to the window in amortized constant time.
+	 *
+	 * @param key new key, larger than every key in the window
+	 */
+	void pushBack(const KeyType& key) noexcept;
+
+	/**
+	 * Removes the smallest key from the window in amortized constant time.
+	 * Does nothing if the window is empty.
+	 */
+	void popFront() noexcept;
+
+private:
+	// buckets before _front have been popped
+	unsigned _front = 0;
+
+	// bucket indices of the left spine from the root down
+	std::deque<unsigned> _leftSpine;
+
+	/**
+	 * Moves the live buckets to the start of the bucket array.
+	 */
+	void compact() noexcept;
+};
+
+template <typename Tree>
+void SlidingWindowIndex<Tree>::pushBack(const KeyType& key) noexcept
+{
+	unsigned xIndex = this->_buckets.size();
+	this->fingerInsert(key);
+
+	// a new maximum only joins the left spine by becoming the root, with the
+	// rest of the window as its left subtree
+	if (this->_rootIndex == xIndex)
+	{
+		_leftSpine.push_front(xIndex);
+	}
+}
+
+template <typename Tree>
+void SlidingWindowIndex<Tree>::popFront() noexcept
+{
+	if (empty())
+	{
+		return;
+	}
+
+	unsigned minIndex = _leftSpine.back();
+	unsigned rightIndex = this->_buckets[minIndex].right;
+	_leftSpine.pop_back();
+
+	// the minimum is only on the right spine when it is the root, and then
+	// its right child takes its place there
+	if (_leftSpine.empty())
+	{
+		this->_rootIndex = rightIndex;
+		if (this->_isRightSpineValid)
+		{
+			this->_rightSpine.pop_front();
+		}
+	}
+	else
+	{
+		this->_buckets[_leftSpine.back()].left = rightIndex;
+	}
+
+	for (unsigned curIndex = rightIndex; curIndex != Tree::NULLPTR; curIndex = this->_buckets[curIndex].left)
+	{
+		_leftSpine.push_back(curIndex);
+	}
+
+	++_front;
+
+	if (_front == this->_buckets.size())
+	{
+		this->_buckets.clear();
+		this->_rootIndex = Tree::NULLPTR;
+		this->_isRightSpineValid = false;
+		_front = 0;
+	}
+	else if (_front >= this->_buckets.size() / 2)
+	{
+		compact();
+	}
+}
+
+template <typename Tree>
+void SlidingWindowIndex<Tree>::compact() noexcept
+{
+	unsigned offset = _front;
+	auto renumber = [offset](unsigned& index) noexcept
+	{
+		if (index != Tree::NULLPTR)
+		{
+			index -= offset;
+		}
+	};
+
+	unsigned size = this->_buckets.size();
+	for (unsigned i = offset; i < size; ++i)
+	{
+		auto bucket = this->_buckets[i];
+		renumber(bucket.left);
+		renumber(bucket.right);
+		this->_buckets[i - offset] = bucket;
+	}
+
+	for (unsigned i = size - offset; i < size; ++i)
+	{
+		this->_buckets.pop_back();
+	}
+
+	renumber(this->_rootIndex);
+	for (unsigned& index : _leftSpine)
+	{
+		renumber(index);
+	}
+
+	for (unsigned& index : this->_rightSpine)
+	{
+		renumber(index);
+	}
+
+	_front = 0;
+}
+
+#endif
@@ -0,0 +1,280 @@
+#include "StreamingStatistics.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	std::string get_entry_key(const std::string& group, const std::string& metric)
+	{
+		return group + '\n' + metric;
+	}
+}
+
+P2Quantile::P2Quantile(double quantile): _quantile(quantile), _count(0)
+{
+	for (int i = 0; i < 5; ++i)
+	{
+		_heights[i] = 0;
+		_positions[i] = i + 1;
+	}
+
+	_desired[0] = 1;
+	_desired[1] = 1 + 2 * quantile;
+	_desired[2] = 1 + 4 * quantile;
+	_desired[3] = 3 + 2 * quantile;
+	_desired[4] = 5;
+
+	_increments[0] = 0;
+	_increments[1] = quantile / 2;
+	_increments[2] = quantile;
+	_increments[3] = (1 + quantile) / 2;
+	_increments[4] = 1;
+}
+
+void P2Quantile::add(double value) noexcept
+{
+	if (_count < 5)
+	{
+		_heights[_count++] = value;
+		if (_count == 5)
+		{
+			std::sort(_heights, _heights + 5);
+		}
+		return;
+	}
+
+	// find the cell the value falls in, extending the extremes if needed
+	int cell;
+	if (value < _heights[0])
+	{
+		_heights[0] = value;
+		cell = 0;
+	}
+	else if (value >= _heights[4])
+	{
+		_heights[4] = value;
+		cell = 3;
+	}
+	else
+	{
+		cell = 0;
+		while (value >= _heights[cell + 1])
+		{
+			++cell;
+		}
+	}
+
+	for (int i = cell + 1; i < 5; ++i)
+	{
+		++_positions[i];
+	}
+
+	for (int i = 0; i < 5; ++i)
+	{
+		_desired[i] += _increments[i];
+	}
+
+	++_count;
+
+	// move the middle markers towards their desired positions
+	for (int i = 1; i < 4; ++i)
+	{
+		double offset = _desired[i] - _positions[i];
+
+		if ((offset >= 1 && _positions[i + 1] - _positions[i] > 1) || (offset <= -1 && _positions[i - 1] - _positions[i] < -1))
+		{
+			int sign = offset > 0 ? 1 : -1;
+			double height = parabolic(i, sign);
+
+			_heights[i] = _heights[i - 1] < height && height < _heights[i + 1] ? height : linear(i, sign);
+			_positions[i] += sign;
+		}
+	}
+}
+
+double P2Quantile::get() const noexcept
+{
+	if (_count == 0)
+	{
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+
+	// up to five values are all kept, so the quantile is exact
+	if (_count <= 5)
+	{
+		double sorted[5];
+		std::copy(_heights, _heights + _count, sorted);
+		std::sort(sorted, sorted + _count);
+		return sorted[static_cast<size_t>(std::lround(_quantile * (_count - 1)))];
+	}
+
+	return _heights[2];
+}
+
+void P2Quantile::save(std::ostream& out) const
+{
+	out << _count;
+	for (const double* markers : {_heights, _positions, _desired})
+	{
+		for (int i = 0; i < 5; ++i)
+		{
+			out << " ";
+			write_double(out, markers[i]);
+		}
+	}
+}
+
+void P2Quantile::load(std::istream& in)
+{
+	in >> _count;
+	for (double* markers : {_heights, _positions, _desired})
+	{
+		for (int i = 0; i < 5; ++i)
+		{
+			read_double(in, markers[i]);
+		}
+	}
+}
+
+double P2Quantile::parabolic(int i, double sign) const noexcept
+{
+	const double* n = _positions;
+	const double* q = _heights;
+
+	return q[i] + sign / (n[i + 1] - n[i - 1]) * ((n[i] - n[i - 1] + sign) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) + (n[i + 1] - n[i] - sign) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double P2Quantile::linear(int i, int sign) const noexcept
+{
+	return _heights[i] + sign * (_heights[i + sign] - _heights[i]) / (_positions[i + sign] - _positions[i]);
+}
+
+StatisticsAggregator::StatisticsAggregator(const std::string& path, const std::string& groupHeader, std::chrono::milliseconds flushInterval)
+	: _path(path), _groupHeader(groupHeader), _flushInterval(flushInterval), _lastFlush(std::chrono::steady_clock::now())
+{
+}
+
+void StatisticsAggregator::add(const std::string& group, const std::string& metric, double value)
+{
+	auto [it, inserted] = _index.try_emplace(get_entry_key(group, metric), _entries.size());
+	if (inserted)
+	{
+		_entries.push_back({group, metric, MetricSummary()});
+	}
+
+	_entries[it->second].summary.add(value);
+}
+
+void StatisticsAggregator::set(const std::string& group, const std::string& metric, double value)
+{
+	auto [it, inserted] = _index.try_emplace(get_entry_key(group, metric), _entries.size());
+	if (inserted)
+	{
+		_entries.push_back({group, metric, MetricSummary()});
+	}
+
+	MetricSummary& summary = _entries[it->second].summary;
+	summary = MetricSummary();
+	summary.add(value);
+}
+
+const MetricSummary* StatisticsAggregator::find(const std::string& group, const std::string& metric) const
+{
+	auto it = _index.find(get_entry_key(group, metric));
+	return it == _index.end() ? nullptr : &_entries[it->second].summary;
+}
+
+void StatisticsAggregator::saveState(std::ostream& out) const
+{
+	// enough digits for every double to read back exactly
+	std::streamsize precision = out.precision(std::numeric_limits<double>::max_digits10);
+
+	out << _entries.size() << "\n";
+	for (const auto& entry : _entries)
+	{
+		out << entry.group << "\t" << entry.metric << "\t";
+		entry.summary.save(out);
+		out << "\n";
+	}
+
+	out.precision(precision);
+}
+
+void StatisticsAggregator::loadState(std::istream& in)
+{
+	size_t numEntries;
+	in >> numEntries;
+	in.ignore();
+
+	_entries.clear();
+	_index.clear();
+
+	for (size_t i = 0; i < numEntries; ++i)
+	{
+		Entry entry;
+		std::getline(in, entry.group, '\t');
+		std::getline(in, entry.metric, '\t');
+		entry.summary.load(in);
+		in.ignore();
+
+		if (!in)
+		{
+			throw std::runtime_error("Truncated statistics state");
+		}
+
+		_index[get_entry_key(entry.group, entry.metric)] = _entries.size();
+		_entries.push_back(std::move(entry));
+	}
+}
+
+bool StatisticsAggregator::flushIfDue()
+{
+	if (std::chrono::steady_clock::now() - _lastFlush < _flushInterval)
+	{
+		return false;
+	}
+
+	flush();
+	return true;
+}
+
+void StatisticsAggregator::flush()
+{
+	std::ostringstream buffer;
+	buffer.precision(10);
+	buffer << _groupHeader << ",metric,count,mean,stddev,min,p50,p90,p99,max\n";
+
+	for (const auto& entry : _entries)
+	{
+		const MetricSummary& summary = entry.summary;
+		const RunningStatistics& statistics = summary.statistics;
+
+		buffer << entry.group << "," << entry.metric << "," << statistics.getCount() << "," << statistics.getMean() << "," << statistics.getStandardDeviation() << ","
+			<< statistics.getMin() << "," << summary.median.get() << "," << summary.p90.get() << "," << summary.p99.get() << "," << statistics.getMax() << "\n";
+	}
+
+	// write aside and rename, so readers never see a partial summary
+	std::string tempPath = _path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::trunc);
+		const std::string contents = buffer.str();
+		file.write(contents.data(), contents.size());
+
+		if (!file)
+		{
+			throw std::runtime_error("Failed to write summary " + tempPath);
+		}
+	}
+
+	if (std::rename(tempPath.c_str(), _path.c_str()) != 0)
+	{
+		throw std::runtime_error("Failed to rename summary to " + _path + ": " + std::strerror(errno));
+	}
+
+	_lastFlush = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,335 @@
+#ifndef STREAMINGSTATISTICS_H
+#define STREAMINGSTATISTICS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Writes a double for read_double. Infinities and NaN are spelled out, since
+ * how operator<< prints them varies and operator>> can't read them back.
+ *
+ * @param out   stream to write to
+ * @param value value to write
+ */
+inline void write_double(std::ostream& out, double value)
+{
+	if (std::isnan(value))
+	{
+		out << "nan";
+	}
+	else if (std::isinf(value))
+	{
+		out << (value > 0 ? "inf" : "-inf");
+	}
+	else
+	{
+		out << value;
+	}
+}
+
+/**
+ * Reads a double written by write_double, setting failbit on a malformed one.
+ *
+ * @param in    stream to read from
+ * @param value receives the value
+ */
+inline void read_double(std::istream& in, double& value)
+{
+	std::string token;
+	if (!(in >> token))
+	{
+		return;
+	}
+
+	// strtod also parses nan, inf and -inf
+	char* end;
+	value = std::strtod(token.c_str(), &end);
+	if (end != token.c_str() + token.size())
+	{
+		in.setstate(std::ios::failbit);
+	}
+}
+
+/**
+ * Count, mean, variance, minimum and maximum of a stream of values in
+ * constant space, using Welford's update for numerically stable variances.
+ */
+class RunningStatistics
+{
+public:
+	void add(double value) noexcept
+	{
+		++_count;
+		double delta = value - _mean;
+		_mean += delta / _count;
+		_m2 += delta * (value - _mean);
+		_min = std::min(_min, value);
+		_max = std::max(_max, value);
+	}
+
+	/**
+	 * Combines the values of another stream into this one (Chan et al.).
+	 *
+	 * @param other statistics of the other stream
+	 */
+	void merge(const RunningStatistics& other) noexcept
+	{
+		if (other._count == 0)
+		{
+			return;
+		}
+
+		uint64_t count = _count + other._count;
+		double delta = other._mean - _mean;
+		_m2 += other._m2 + delta * delta * _count * other._count / count;
+		_mean += delta * other._count / count;
+		_count = count;
+		_min = std::min(_min, other._min);
+		_max = std::max(_max, other._max);
+	}
+
+	uint64_t getCount() const noexcept
+	{
+		return _count;
+	}
+
+	double getMean() const noexcept
+	{
+		return _mean;
+	}
+
+	/**
+	 * @return sample variance, or 0 for fewer than two values
+	 */
+	double getVariance() const noexcept
+	{
+		return _count > 1 ? _m2 / (_count - 1) : 0;
+	}
+
+	double getStandardDeviation() const noexcept
+	{
+		return std::sqrt(getVariance());
+	}
+
+	/**
+	 * @return standard error of the mean, or infinity for fewer than two values
+	 */
+	double getStandardError() const noexcept
+	{
+		return _count > 1 ? std::sqrt(getVariance() / _count) : std::numeric_limits<double>::infinity();
+	}
+
+	double getMin() const noexcept
+	{
+		return _min;
+	}
+
+	double getMax() const noexcept
+	{
+		return _max;
+	}
+
+	/**
+	 * Writes the state as text, for load to pick up later. The stream's
+	 * precision decides whether values read back exactly.
+	 */
+	void save(std::ostream& out) const
+	{
+		out << _count;
+		for (double value : {_mean, _m2, _min, _max})
+		{
+			out << " ";
+			write_double(out, value);
+		}
+	}
+
+	void load(std::istream& in)
+	{
+		in >> _count;
+		for (double* value : {&_mean, &_m2, &_min, &_max})
+		{
+			read_double(in, *value);
+		}
+	}
+
+private:
+	uint64_t _count = 0;
+	double _mean = 0;
+	double _m2 = 0;
+	double _min = std::numeric_limits<double>::infinity();
+	double _max = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * Estimates one quantile of a stream in constant space with the P² algorithm
+ * (Jain and Chlamtac), which keeps five markers whose heights are adjusted
+ * with piecewise-parabolic interpolation as values arrive. The estimate is
+ * exact for up to five values.
+ */
+class P2Quantile
+{
+public:
+	/**
+	 * @param quantile quantile to estimate, within (0, 1)
+	 */
+	explicit P2Quantile(double quantile);
+
+	void add(double value) noexcept;
+
+	/**
+	 * @return estimated quantile, or NaN if no values were added
+	 */
+	double get() const noexcept;
+
+	/**
+	 * Writes the state as text, for load to pick up later. The stream's
+	 * precision decides whether values read back exactly.
+	 */
+	void save(std::ostream& out) const;
+	void load(std::istream& in);
+
+private:
+	double _quantile;
+	uint64_t _count;
+	// marker heights, actual positions, desired positions and their increments
+	double _heights[5];
+	double _positions[5];
+	double _desired[5];
+	double _increments[5];
+
+	double parabolic(int i, double sign) const noexcept;
+	double linear(int i, int sign) const noexcept;
+};
+
+/**
+ * Streaming summary of one metric: moments, extremes and quantile sketches.
+ */
+struct MetricSummary
+{
+	RunningStatistics statistics;
+	P2Quantile median{0.5};
+	P2Quantile p90{0.9};
+	P2Quantile p99{0.99};
+
+	void add(double value) noexcept
+	{
+		statistics.add(value);
+		median.add(value);
+		p90.add(value);
+		p99.add(value);
+	}
+
+	void save(std::ostream& out) const
+	{
+		statistics.save(out);
+		for (const P2Quantile* quantile : {&median, &p90, &p99})
+		{
+			out << " ";
+			quantile->save(out);
+		}
+	}
+
+	void load(std::istream& in)
+	{
+		statistics.load(in);
+		for (P2Quantile* quantile : {&median, &p90, &p99})
+		{
+			quantile->load(in);
+		}
+	}
+};
+
+/**
+ * Aggregates metric values per group (e.g. one tree configuration) instead of
+ * keeping raw rows, and periodically writes one compact summary row per
+ * (group, metric) to a CSV file. Each flush rewrites the whole file with a
+ * single buffered write and renames it into place, so the file always holds
+ * a complete, current summary.
+ */
+class StatisticsAggregator
+{
+public:
+	/**
+	 * @param path          summary file to create or overwrite
+	 * @param groupHeader   CSV header of the group columns, e.g. "tree,n"
+	 * @param flushInterval minimum time between periodic flushes
+	 */
+	StatisticsAggregator(const std::string& path, const std::string& groupHeader, std::chrono::milliseconds flushInterval = std::chrono::seconds(10));
+
+	/**
+	 * @param group  CSV fields identifying the group, matching groupHeader
+	 * @param metric metric name
+	 * @param value  new value of the metric
+	 */
+	void add(const std::string& group, const std::string& metric, double value);
+
+	/**
+	 * Replaces the summary of a metric with a single value, for metrics
+	 * computed over every trial at once rather than one value per trial.
+	 *
+	 * @param group  CSV fields identifying the group, matching groupHeader
+	 * @param metric metric name
+	 * @param value  value of the metric
+	 */
+	void set(const std::string& group, const std::string& metric, double value);
+
+	/**
+	 * @return the summary of a metric, or nullptr if it has no values yet
+	 */
+	const MetricSummary* find(const std::string& group, const std::string& metric) const;
+
+	/**
+	 * Writes every summary, one per line, so a restarted run can continue
+	 * aggregating where this one stopped.
+	 *
+	 * @param out stream to write the state to
+	 */
+	void saveState(std::ostream& out) const;
+
+	/**
+	 * Replaces every summary with those written by saveState.
+	 *
+	 * @param in stream positioned at the saved state
+	 */
+	void loadState(std::istream& in);
+
+	/**
+	 * Flushes if the flush interval has passed since the last flush.
+	 *
+	 * @return true if the summary was flushed
+	 */
+	bool flushIfDue();
+
+	/**
+	 * Writes the summaries of every group and metric seen so far.
+	 */
+	void flush();
+
+private:
+	struct Entry
+	{
+		std::string group;
+		std::string metric;
+		MetricSummary summary;
+	};
+
+	std::string _path;
+	std::string _groupHeader;
+	std::chrono::milliseconds _flushInterval;
+	std::chrono::steady_clock::time_point _lastFlush;
+	// entries in the order they were first seen, and their index by key
+	std::vector<Entry> _entries;
+	std::unordered_map<std::string, size_t> _index;
+};
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef STRINGZIPTREE_H
+#define STRINGZIPTREE_H
+
+#include "ZipTreeMap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The characters of the keys of a StringZipTree, and the longest prefix
+ * shared by all of them, which no comparison needs to look at.
+ */
+struct StringArena
+{
+	std::vector<char> bytes;
+	std::string shared;
+};
+
+/**
+ * A string key as stored in a StringZipTree bucket: the first 8 bytes after
+ * the shared prefix packed big-endian into an integer, zero-padded, and the
+ * location of the whole string in the arena.
+ */
+struct PrefixedString
+{
+	uint64_t prefix;
+	uint32_t offset;
+	uint32_t length;
+};
+
+/**
+ * A string being looked up, with its prefix computed once per lookup rather
+ * than once per comparison. A string that doesn't start with the shared
+ * prefix is smaller (side -1) or larger (side 1) than every key.
+ */
+struct StringProbe
+{
+	uint64_t prefix;
+	std::string_view view;
+	int side;
+};
+
+/**
+ * @return first 8 bytes of a string as a big-endian integer, zero-padded, so
+ *         that integer order agrees with lexicographic order on them
+ */
+inline uint64_t get_string_prefix(std::string_view view) noexcept
+{
+	uint64_t prefix = 0;
+	std::memcpy(&prefix, view.data(), std::min<size_t>(view.size(), sizeof(prefix)));
+
+	if constexpr (std::endian::native == std::endian::little)
+	{
+		prefix = __builtin_bswap64(prefix);
+	}
+
+	return prefix;
+}
+
+/**
+ * Orders PrefixedStrings and StringProbes lexicographically. Differing
+ * prefixes decide a comparison without reading the arena; only keys sharing
+ * their first 8 bytes after the shared prefix compare the rest of the strings.
+ */
+class PrefixedStringCompare
+{
+public:
+	typedef void is_transparent;
+
+	explicit PrefixedStringCompare(const StringArena* arena = nullptr) noexcept: _arena(arena)
+	{
+	}
+
+	std::string_view getView(const PrefixedString& key) const noexcept
+	{
+		return {_arena->bytes.data() + key.offset, key.length};
+	}
+
+	bool operator()(const PrefixedString& a, const PrefixedString& b) const noexcept
+	{
+		return a.prefix != b.prefix ? a.prefix < b.prefix : isTailLess(getView(a), getView(b));
+	}
+
+	bool operator()(const PrefixedString& a, const StringProbe& b) const noexcept
+	{
+		if (b.side != 0)
+		{
+			return b.side > 0;
+		}
+
+		return a.prefix != b.prefix ? a.prefix < b.prefix : isTailLess(getView(a), b.view);
+	}
+
+	bool operator()(const StringProbe& a, const PrefixedString& b) const noexcept
+	{
+		if (a.side != 0)
+		{
+			return a.side < 0;
+		}
+
+		return a.prefix != b.prefix ? a.prefix < b.prefix : isTailLess(a.view, getView(b));
+	}
+
+private:
+	const StringArena* _arena;
+
+	/**
+	 * Compares two strings that start with the shared prefix and have equal
+	 * prefixes after it. Those 8 bytes agree up to the shorter length and are
+	 * zero past it, so the bytes after them decide, and on a tie the shorter
+	 * string is smaller.
+	 */
+	bool isTailLess(std::string_view a, std::string_view b) const noexcept
+	{
+		size_t skip = _arena->shared.size() + sizeof(uint64_t);
+		int order = a.substr(std::min(a.size(), skip)).compare(b.substr(std::min(b.size(), skip)));
+		return order != 0 ? order < 0 : a.size() < b.size();
+	}
+};
+
+/**
+ * Ordered set of strings on the array zip tree, for indexes of URLs, paths
+ * and other string keys. A bucket of GeneralizedZipTree<std::string, ...>
+ * holds a std::string, so every comparison chases a pointer into the heap.
+ * Here a bucket holds a PrefixedString instead, and the characters of all
+ * keys are appended to one arena: a descent reads the arena only at nodes
+ * whose key agrees with the one searched for on the 8 bytes of the prefix,
+ * which with varied keys is mostly the last node or two.
+ *
+ * Keys like URLs mostly start the same way, so the prefix is taken after the
+ * longest prefix shared by every key inserted since the tree was last empty,
+ * e.g. after "https://example.com/". That shared prefix only ever shrinks,
+ * and each time it does every bucket's prefix is recomputed, which happens
+ * at most once per byte of the first key and mostly while the tree is small.
+ *
+ * Buckets stay trivially copyable, and removed keys leave their bytes in the
+ * arena until they make up half of it, when the live keys are copied into a
+ * fresh arena. Offsets are 32-bit, so the arena holds up to 4 GiB.
+ */
+class StringZipTree
+{
+public:
+	/**
+	 * @param maxSize    number of keys to reserve space for
+	 * @param arenaBytes number of key bytes to reserve space for
+	 */
+	StringZipTree(unsigned maxSize, size_t arenaBytes = 0): _index(maxSize, PrefixedStringCompare(&_arena))
+	{
+		_arena.bytes.reserve(arenaBytes);
+	}
+
+	// the comparator points at the arena of this tree
+	StringZipTree(const StringZipTree&) = delete;
+	StringZipTree& operator=(const StringZipTree&) = delete;
+
+	/**
+	 * Inserts a key unless it is already present.
+	 *
+	 * @param  key key to insert
+	 * @return     true if the key was inserted, false if it was present
+	 * @throws     std::length_error if the arena would grow past 4 GiB
+	 */
+	bool insert(std::string_view key)
+	{
+		if (_index.getSize() == 0)
+		{
+			_arena.shared = key;
+		}
+
+		StringProbe probe = makeProbe(key);
+		if (probe.side == 0 && _index.find(probe))
+		{
+			return false;
+		}
+
+		if (_arena.bytes.size() + key.size() > std::numeric_limits<uint32_t>::max())
+		{
+			throw std::length_error("StringZipTree arena would exceed 4 GiB");
+		}
+
+		// the new key is compared as it is linked in, so it must be in the
+		// arena first
+		uint32_t offset = _arena.bytes.size();
+		_arena.bytes.insert(_arena.bytes.end(), key.begin(), key.end());
+
+		if (probe.side != 0)
+		{
+			auto mismatch = std::mismatch(_arena.shared.begin(), _arena.shared.end(), key.begin(), key.end());
+			_arena.shared.resize(mismatch.first - _arena.shared.begin());
+			_index.updatePrefixes(_arena.shared.size());
+		}
+
+		_index.insert(PrefixedString{get_string_prefix(key.substr(_arena.shared.size())), offset, static_cast<uint32_t>(key.size())});
+		return true;
+	}
+
+	/**
+	 * @param  key key to remove
+	 * @return     true if the key was removed, false if it was absent
+	 */
+	bool remove(std::string_view key)
+	{
+		if (!_index.remove(makeProbe(key)))
+		{
+			return false;
+		}
+
+		_deadBytes += key.size();
+		if (_deadBytes > _arena.bytes.size() / 2)
+		{
+			compactArena();
+		}
+
+		return true;
+	}
+
+	bool find(std::string_view key) const noexcept
+	{
+		return _index.find(makeProbe(key));
+	}
+
+	int getDepth(std::string_view key) const noexcept
+	{
+		return _index.getDepth(makeProbe(key));
+	}
+
+	/**
+	 * @param  low  smallest key to count
+	 * @param  high largest key to count
+	 * @return      number of keys within [low, high]
+	 */
+	unsigned countRange(std::string_view low, std::string_view high) const noexcept
+	{
+		return _index.countRange(makeProbe(low), makeProbe(high));
+	}
+
+	/**
+	 * Calls visit(key) for every key within [low, high], in increasing order.
+	 * The views are invalidated by the next insert or remove.
+	 *
+	 * @param low   smallest key to visit
+	 * @param high  largest key to visit
+	 * @param visit callback receiving each key as a std::string_view
+	 */
+	template <typename Visit>
+	void forEachInRange(std::string_view low, std::string_view high, Visit&& visit) const
+	{
+		const PrefixedStringCompare& compare = _index.getCompare();
+		_index.forEachInRange(makeProbe(low), makeProbe(high), [&compare, &visit](const PrefixedString& key) { visit(compare.getView(key)); });
+	}
+
+	unsigned getSize() const noexcept
+	{
+		return _index.getSize();
+	}
+
+	bool empty() const noexcept
+	{
+		return getSize() == 0;
+	}
+
+	int getHeight() const noexcept
+	{
+		return _index.getHeight();
+	}
+
+	/**
+	 * @return bytes of the arena, including those of removed keys not yet
+	 *         compacted away
+	 */
+	size_t getArenaSize() const noexcept
+	{
+		return _arena.bytes.size();
+	}
+
+	/**
+	 * @return the prefix shared by every key, which comparisons skip
+	 */
+	std::string_view getSharedPrefix() const noexcept
+	{
+		return _arena.shared;
+	}
+
+	TreeStatistics getStatistics(ThreadPool* pool = nullptr) const
+	{
+		return _index.getStatistics(pool);
+	}
+
+	/**
+	 * Reports the buckets as GeneralizedZipTree does, with the arena counted
+	 * towards the keys.
+	 */
+	MemoryUsage memoryUsage() const noexcept
+	{
+		MemoryUsage usage = _index.memoryUsage();
+		usage.keys += _arena.bytes.size();
+		usage.capacityHeadroom += _arena.bytes.capacity() - _arena.bytes.size();
+		return usage;
+	}
+
+	bool setStructuralCounters(StructuralCounters* counters) noexcept
+	{
+		return _index.setStructuralCounters(counters);
+	}
+
+private:
+	/**
+	 * The tree of the keys, with access to the buckets for updating prefixes
+	 * and compacting the arena.
+	 */
+	class Index : public GeneralizedZipTree<PrefixedString, MapRank, PrefixedStringCompare>
+	{
+		typedef GeneralizedZipTree<PrefixedString, MapRank, PrefixedStringCompare> Base;
+
+	public:
+		Index(unsigned maxSize, const PrefixedStringCompare& compare): Base(maxSize, compare)
+		{
+		}
+
+		/**
+		 * Recomputes every prefix after the shared prefix has shrunk. The
+		 * order of the keys doesn't change, so neither does the tree.
+		 *
+		 * @param sharedLength new length of the shared prefix
+		 */
+		void updatePrefixes(size_t sharedLength) noexcept
+		{
+			for (unsigned i = 0; i < this->_buckets.size(); ++i)
+			{
+				PrefixedString& key = this->_buckets[i].key;
+				key.prefix = get_string_prefix(this->_compare.getView(key).substr(sharedLength));
+			}
+		}
+
+		/**
+		 * Copies the keys into a new arena and points the buckets at their
+		 * copies.
+		 */
+		void moveKeys(const std::vector<char>& from, std::vector<char>& to)
+		{
+			for (unsigned i = 0; i < this->_buckets.size(); ++i)
+			{
+				PrefixedString& key = this->_buckets[i].key;
+				uint32_t offset = to.size();
+				to.insert(to.end(), from.begin() + key.offset, from.begin() + key.offset + key.length);
+				key.offset = offset;
+			}
+		}
+
+	protected:
+		MapRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* /* bothTies */) const noexcept override
+		{
+			return {get_random_geometric(), totalComparisons, firstTies};
+		}
+	};
+
+	// declared before _index, whose comparator points at it
+	StringArena _arena;
+	size_t _deadBytes = 0;
+	Index _index;
+
+	/**
+	 * @return a probe for looking up a key, placed below or above every key
+	 *         if it doesn't start with the shared prefix
+	 */
+	StringProbe makeProbe(std::string_view key) const noexcept
+	{
+		std::string_view shared = _arena.shared;
+		int order = key.substr(0, shared.size()).compare(shared);
+		if (order != 0)
+		{
+			return {0, key, order < 0 ? -1 : 1};
+		}
+
+		return {get_string_prefix(key.substr(shared.size())), key, 0};
+	}
+
+	void compactArena()
+	{
+		std::vector<char> bytes;
+		bytes.reserve(_arena.bytes.size() - _deadBytes);
+		_index.moveKeys(_arena.bytes, bytes);
+
+		// the comparator points at _arena itself, so swap the contents in
+		_arena.bytes.swap(bytes);
+		_deadBytes = 0;
+	}
+};
+
+#endif
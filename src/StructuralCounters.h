@@ -0,0 +1,115 @@
+#ifndef STRUCTURALCOUNTERS_H
+#define STRUCTURALCOUNTERS_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Structural work done by tree operations: key comparisons, child links
+ * written, buckets moved, and the lengths of the paths insertions unzip and
+ * removals zip. Link writes and moves are the stores that dirty cache lines
+ * (or pages of a file-backed tree), so they predict write amplification
+ * better than comparison counts.
+ *
+ * Trees only count into an object attached with setStructuralCounters.
+ */
+struct StructuralCounters
+{
+	// finds, and removes of absent keys
+	uint64_t finds = 0;
+	uint64_t inserts = 0;
+	uint64_t removes = 0;
+
+	uint64_t keyComparisons = 0;
+	uint64_t linkWrites = 0;
+	// buckets copied into the slot of a removed one
+	uint64_t bucketMoves = 0;
+
+	// unzipLengths[l] is the number of inserts that unzipped a path of l nodes
+	std::vector<uint64_t> unzipLengths;
+	// zipLengths[l] is the number of removes that zipped a path of l nodes
+	std::vector<uint64_t> zipLengths;
+	// linkWritesPerUpdate[w] is the number of inserts and removes writing w links
+	std::vector<uint64_t> linkWritesPerUpdate;
+
+	void recordFind(uint64_t comparisons) noexcept
+	{
+		++finds;
+		keyComparisons += comparisons;
+	}
+
+	void recordInsert(uint64_t comparisons, unsigned unzipLength, unsigned writes)
+	{
+		++inserts;
+		keyComparisons += comparisons;
+		linkWrites += writes;
+		addToHistogram(unzipLengths, unzipLength);
+		addToHistogram(linkWritesPerUpdate, writes);
+	}
+
+	void recordRemove(uint64_t comparisons, unsigned zipLength, unsigned writes, bool movedBucket)
+	{
+		++removes;
+		keyComparisons += comparisons;
+		linkWrites += writes;
+		bucketMoves += movedBucket;
+		addToHistogram(zipLengths, zipLength);
+		addToHistogram(linkWritesPerUpdate, writes);
+	}
+
+	/**
+	 * @param  histogram one of the histograms above
+	 * @return           mean of the histogram, or 0 if it is empty
+	 */
+	static double getMean(const std::vector<uint64_t>& histogram) noexcept
+	{
+		uint64_t count = 0, total = 0;
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			count += histogram[i];
+			total += i * histogram[i];
+		}
+
+		return count > 0 ? static_cast<double>(total) / count : 0;
+	}
+
+	/**
+	 * @param  histogram one of the histograms above
+	 * @param  quantile  quantile within [0, 1]
+	 * @return           smallest length with at least that fraction of the
+	 *                   counts at or below it, or 0 if the histogram is empty
+	 */
+	static unsigned getQuantile(const std::vector<uint64_t>& histogram, double quantile) noexcept
+	{
+		uint64_t count = 0;
+		for (uint64_t bucket : histogram)
+		{
+			count += bucket;
+		}
+
+		uint64_t seen = 0;
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			seen += histogram[i];
+			if (seen > 0 && seen >= quantile * count)
+			{
+				return i;
+			}
+		}
+
+		return 0;
+	}
+
+private:
+	static void addToHistogram(std::vector<uint64_t>& histogram, unsigned value)
+	{
+		if (value >= histogram.size())
+		{
+			histogram.resize(value + 1);
+		}
+
+		++histogram[value];
+	}
+};
+
+#endif
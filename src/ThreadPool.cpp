@@ -0,0 +1,177 @@
+#include "ThreadPool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+
+namespace
+{
+	// the pool the current thread works for, and its index in that pool
+	thread_local const ThreadPool* current_pool = nullptr;
+	thread_local unsigned current_worker_index = 0;
+
+	/**
+	 * @return the CPUs this process may run on
+	 */
+	std::vector<int> get_allowed_cpus()
+	{
+		std::vector<int> cpus;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+
+		if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		{
+			for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			{
+				if (CPU_ISSET(cpu, &set))
+				{
+					cpus.push_back(cpu);
+				}
+			}
+		}
+
+		return cpus;
+	}
+}
+
+ThreadPool::ThreadPool(unsigned numThreads, bool pinThreads): _numPending(0), _stopping(false)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	_queues.reserve(numThreads);
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		_queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	std::vector<int> cpus = pinThreads ? get_allowed_cpus() : std::vector<int>();
+
+	_workers.reserve(numThreads);
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+
+		// pinning is only a hint, so workers just float if it fails
+		if (!cpus.empty())
+		{
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpus[i % cpus.size()], &set);
+			pthread_setaffinity_np(_workers.back().native_handle(), sizeof(set), &set);
+		}
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+
+	_condition.notify_all();
+	for (auto& worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+int ThreadPool::getWorkerIndex() const noexcept
+{
+	return current_pool == this ? static_cast<int>(current_worker_index) : -1;
+}
+
+void ThreadPool::push(std::function<void()> task)
+{
+	int workerIndex = getWorkerIndex();
+	WorkerQueue& queue = workerIndex != -1 ? *_queues[workerIndex] : _external;
+
+	// counted before it is queued, so the count never drops below zero
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_numPending;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	_condition.notify_one();
+}
+
+bool ThreadPool::tryPop(unsigned workerIndex, std::function<void()>& task)
+{
+	// own queue first, newest task first
+	{
+		WorkerQueue& queue = *_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			--_numPending;
+			return true;
+		}
+	}
+
+	// then the oldest task submitted from outside the pool
+	{
+		std::lock_guard<std::mutex> lock(_external.mutex);
+
+		if (!_external.tasks.empty())
+		{
+			task = std::move(_external.tasks.front());
+			_external.tasks.pop_front();
+			--_numPending;
+			return true;
+		}
+	}
+
+	// then steal the oldest task of another worker
+	for (unsigned i = 1; i < _queues.size(); ++i)
+	{
+		WorkerQueue& queue = *_queues[(workerIndex + i) % _queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			--_numPending;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::workerLoop(unsigned workerIndex)
+{
+	current_pool = this;
+	current_worker_index = workerIndex;
+
+	while (true)
+	{
+		std::function<void()> task;
+
+		if (tryPop(workerIndex, task))
+		{
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this] { return _stopping || _numPending > 0; });
+
+		if (_stopping && _numPending == 0)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A fixed-size work-stealing pool of worker threads. Each worker has its own
+ * task queue: tasks submitted by a worker go to the back of its own queue and
+ * are run newest first. Tasks submitted from outside the pool go to a shared
+ * queue and are started in submission order, once a worker's own queue is
+ * empty. Idle workers then steal the oldest task of another worker.
+ *
+ * The destructor finishes all queued tasks before joining the workers.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @param numThreads number of worker threads, 0 to use every hardware thread
+	 * @param pinThreads pin worker i to the i-th CPU this process may run on
+	 */
+	explicit ThreadPool(unsigned numThreads = 0, bool pinThreads = false);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * Queues a task to be run by one of the workers.
+	 *
+	 * @param  task callable taking no arguments
+	 * @return      future holding the result of the task
+	 */
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F&& task);
+
+	/**
+	 * @return number of worker threads
+	 */
+	unsigned getNumThreads() const noexcept
+	{
+		return _workers.size();
+	}
+
+	/**
+	 * @return index of the calling worker thread of this pool, or -1 when
+	 *         called from any other thread
+	 */
+	int getWorkerIndex() const noexcept;
+
+private:
+	struct WorkerQueue
+	{
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+	};
+
+	std::vector<std::thread> _workers;
+	std::vector<std::unique_ptr<WorkerQueue>> _queues;
+	// tasks submitted from outside the pool, run oldest first
+	WorkerQueue _external;
+	// tasks queued but not yet taken by a worker
+	std::atomic<size_t> _numPending;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stopping;
+
+	void push(std::function<void()> task);
+	bool tryPop(unsigned workerIndex, std::function<void()>& task);
+	void workerLoop(unsigned workerIndex);
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F&& task)
+{
+	auto packaged = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+	auto future = packaged->get_future();
+
+	push([packaged] { (*packaged)(); });
+	return future;
+}
+
+#endif
@@ -21,6 +21,13 @@ struct TreapRank
 	uint64_t* totalComparisons;
 	uint64_t* firstTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = false;
+
+	uint64_t getValue() const noexcept
+	{
+		return urank;
+	}
+
 	inline int updateComparisons(const TreapRank& other) const noexcept
 	{
 		// ++(*totalComparisons);
@@ -66,9 +73,9 @@ namespace
 	 */
 	TreapRank getRandomTreapRank(uint64_t maxURank, uint64_t* totalComparisons, uint64_t* firstTies) noexcept
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
-		static std::geometric_distribution<uint8_t> gdistribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
+		thread_local std::geometric_distribution<uint8_t> gdistribution(0.5);
 		std::uniform_int_distribution<uint64_t> udistribution(0, maxURank);
 
 		return {udistribution(generator), totalComparisons, firstTies};
@@ -201,7 +208,7 @@ bool Treap<KeyType>::remove(const KeyType& key) noexcept
 
 	_head = std::unique_ptr<Node>(removeRecursive(key, _head));
 
-	return prevSize == _size;
+	return prevSize != _size;
 }
 
 template <typename KeyType>
@@ -212,7 +219,7 @@ typename Treap<KeyType>::Node* Treap<KeyType>::removeRecursive(const KeyType& ke
 		return root.release();
 	}
 
-	if (key == root->key)
+	if (!(key < root->key) && !(root->key < key))
 	{
 		--_size;
 		return zip(root->left.release(), root->right.release());
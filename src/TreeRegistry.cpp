@@ -0,0 +1,35 @@
+#include "TreeRegistry.h"
+
+// headers the tree headers include, pulled in first so their include guards
+// keep them out of the namespace below
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace pointer_trees
+{
+#include "ZipTree.h"
+#include "ZipZipTree.h"
+#include "Treap.h"
+}
+
+const TreeRegistry& get_tree_registry()
+{
+	static const TreeRegistry registry = []
+	{
+		TreeRegistry registry;
+		register_pointer_trees(registry);
+		register_array_trees(registry);
+		register_array_tree_variants(registry);
+		return registry;
+	}();
+
+	return registry;
+}
+
+void register_pointer_trees(TreeRegistry& registry)
+{
+	registry["original"] = {[](const TreeParameters& parameters) { return std::make_unique<pointer_trees::ZipTree<unsigned>>(parameters.maxSize); }};
+	registry["zipzip"] = {[](const TreeParameters& parameters) { return std::make_unique<pointer_trees::ZipZipTree<unsigned>>(parameters.maxSize); }};
+	registry["treap"] = {[](const TreeParameters& parameters) { return std::make_unique<pointer_trees::Treap<unsigned>>(parameters.maxSize); }};
+}
@@ -0,0 +1,46 @@
+#ifndef TREEREGISTRY_H
+#define TREEREGISTRY_H
+
+#include "BinarySearchTree.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * Construction parameters shared by every tree variant. Variants ignore the
+ * parameters they don't use.
+ */
+struct TreeParameters
+{
+	// number of nodes to reserve space for
+	unsigned maxSize = 0;
+	// rank distribution parameter of the variable-p zip tree, within (0, 1)
+	double p = 0.5;
+};
+
+typedef std::function<std::unique_ptr<BinarySearchTree<unsigned>>(const TreeParameters& parameters)> TreeFactory;
+
+struct TreeVariant
+{
+	TreeFactory factory;
+	// whether the variant depends on TreeParameters::p
+	bool usesP = false;
+};
+
+typedef std::map<std::string, TreeVariant> TreeRegistry;
+
+/**
+ * @return every tree variant in the repository, by name
+ */
+const TreeRegistry& get_tree_registry();
+
+// Several tree headers declare classes with the same names (e.g. ZipTree is
+// both the pointer and the array zip tree), so each family is registered from
+// its own translation unit, inside its own namespace.
+void register_pointer_trees(TreeRegistry& registry);
+void register_array_trees(TreeRegistry& registry);
+void register_array_tree_variants(TreeRegistry& registry);
+
+#endif
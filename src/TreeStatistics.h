@@ -0,0 +1,252 @@
+#ifndef TREESTATISTICS_H
+#define TREESTATISTICS_H
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+constexpr std::array<uint8_t, 256> BITS_REQUIRED = []{
+	std::array<uint8_t, 256> table{};
+	for (size_t i = 0; i < table.size(); i++)
+		for (uint8_t j = i; j > 0; j >>= 1)
+			table[i]++;
+	table[0] = 1;
+	return table;
+}();
+
+namespace
+{
+	inline uint8_t num_bits_required(uint64_t value)
+	{
+		if (value < BITS_REQUIRED.size())
+		{
+			return BITS_REQUIRED[value];
+		}
+
+		uint8_t bits = 0;
+		while (value > 0)
+		{
+			++bits;
+			value >>= 1;
+		}
+
+		return bits;
+	}
+}
+
+/**
+ * Shape statistics of a whole tree, gathered in a single traversal.
+ *
+ * Rank values are the primary component of a rank (see the getValue member of
+ * the rank structs). Rank types whose values can be huge, such as the uniform
+ * treap ranks, set HISTOGRAM_BY_VALUE to false, in which case rankHistogram is
+ * bucketed by the bit width of the rank value instead of by the value itself.
+ */
+struct TreeStatistics
+{
+	uint64_t size = 0;
+	int height = -1;
+	uint64_t totalDepth = 0;
+
+	// bits needed to store each rank as the difference from its parent's rank
+	// (the root stores its full rank), as in DynamicZipTree's
+	// getTotalGeometricBits
+	uint64_t totalRankBits = 0;
+	// the largest of those differences, leaving out the root's full rank, as
+	// in DynamicZipTree's getMaxGeometricBits
+	uint8_t maxRankBits = 0;
+
+	// depthHistogram[d] is the number of nodes at depth d
+	std::vector<uint64_t> depthHistogram;
+	// rankHistogram[r] is the number of nodes with rank value (or bit width) r
+	std::vector<uint64_t> rankHistogram;
+
+	/**
+	 * @return average node depth, as returned by getAverageHeight
+	 */
+	double getAverageDepth() const noexcept
+	{
+		return static_cast<double>(totalDepth) / size;
+	}
+
+	void addNode(unsigned depth, uint64_t rankBucket, uint8_t rankBits)
+	{
+		++size;
+		height = std::max(height, static_cast<int>(depth));
+		totalDepth += depth;
+		totalRankBits += rankBits;
+		if (depth > 0)
+		{
+			maxRankBits = std::max(maxRankBits, rankBits);
+		}
+
+		if (depthHistogram.size() <= depth)
+		{
+			depthHistogram.resize(depth + 1);
+		}
+		++depthHistogram[depth];
+
+		if (rankHistogram.size() <= rankBucket)
+		{
+			rankHistogram.resize(rankBucket + 1);
+		}
+		++rankHistogram[rankBucket];
+	}
+
+	void merge(const TreeStatistics& other)
+	{
+		size += other.size;
+		height = std::max(height, other.height);
+		totalDepth += other.totalDepth;
+		totalRankBits += other.totalRankBits;
+		maxRankBits = std::max(maxRankBits, other.maxRankBits);
+
+		mergeHistogram(depthHistogram, other.depthHistogram);
+		mergeHistogram(rankHistogram, other.rankHistogram);
+	}
+
+private:
+	static void mergeHistogram(std::vector<uint64_t>& into, const std::vector<uint64_t>& from)
+	{
+		if (into.size() < from.size())
+		{
+			into.resize(from.size());
+		}
+
+		for (size_t i = 0; i < from.size(); ++i)
+		{
+			into[i] += from[i];
+		}
+	}
+};
+
+/**
+ * Gathers TreeStatistics for the tree under root using an explicit stack, so
+ * degenerate trees cannot overflow the call stack. When a thread pool is
+ * given, the top levels are expanded until there are enough subtrees to keep
+ * every worker busy, and each subtree is then traversed as a separate task.
+ * The pool's workers don't help while waiting on tasks, so when called from a
+ * task running on the pool itself, the traversal runs inline instead.
+ *
+ * @param  root         root node reference, may be null
+ * @param  null         the null node reference (nullptr or NULLPTR)
+ * @param  getChildren  returns a (left, right) pair for a node reference
+ * @param  getRankValue returns the rank value of a node reference
+ * @param  pool         thread pool to split subtrees across, or nullptr
+ * @return              statistics of the whole tree
+ */
+template <bool HistogramByValue, typename NodeRef, typename GetChildren, typename GetRankValue>
+TreeStatistics collectTreeStatistics(NodeRef root, NodeRef null, GetChildren getChildren, GetRankValue getRankValue, ThreadPool* pool)
+{
+	struct Frame
+	{
+		NodeRef node;
+		unsigned depth;
+		uint64_t parentRank;
+		bool hasParent;
+	};
+
+	// visits a single node, returning its rank value for its children
+	auto visit = [&](TreeStatistics& stats, const Frame& frame) -> uint64_t
+	{
+		uint64_t rank = getRankValue(frame.node);
+		uint64_t rankBucket = HistogramByValue ? rank : std::bit_width(rank);
+		uint8_t rankBits = num_bits_required(frame.hasParent ? frame.parentRank - rank : rank);
+
+		stats.addNode(frame.depth, rankBucket, rankBits);
+		return rank;
+	};
+
+	auto visitSubtree = [&](Frame start) -> TreeStatistics
+	{
+		TreeStatistics stats;
+		std::vector<Frame> stack{start};
+
+		while (!stack.empty())
+		{
+			Frame frame = stack.back();
+			stack.pop_back();
+
+			uint64_t rank = visit(stats, frame);
+			auto [left, right] = getChildren(frame.node);
+
+			if (right != null)
+			{
+				stack.push_back({right, frame.depth + 1, rank, true});
+			}
+
+			if (left != null)
+			{
+				stack.push_back({left, frame.depth + 1, rank, true});
+			}
+		}
+
+		return stats;
+	};
+
+	if (root == null)
+	{
+		return TreeStatistics();
+	}
+
+	Frame rootFrame = {root, 0, 0, false};
+
+	if (pool == nullptr || pool->getNumThreads() <= 1 || pool->getWorkerIndex() != -1)
+	{
+		return visitSubtree(rootFrame);
+	}
+
+	// expand whole levels until there are several subtrees per worker, giving
+	// up on degenerate trees that never widen
+	static constexpr unsigned SUBTREES_PER_THREAD = 8;
+	static constexpr unsigned MAX_EXPANDED_LEVELS = 64;
+
+	TreeStatistics stats;
+	std::vector<Frame> frontier{rootFrame};
+
+	for (unsigned level = 0; level < MAX_EXPANDED_LEVELS && frontier.size() < pool->getNumThreads() * SUBTREES_PER_THREAD; ++level)
+	{
+		std::vector<Frame> next;
+		next.reserve(frontier.size() * 2);
+
+		for (const auto& frame : frontier)
+		{
+			uint64_t rank = visit(stats, frame);
+			auto [left, right] = getChildren(frame.node);
+
+			if (left != null)
+			{
+				next.push_back({left, frame.depth + 1, rank, true});
+			}
+
+			if (right != null)
+			{
+				next.push_back({right, frame.depth + 1, rank, true});
+			}
+		}
+
+		frontier = std::move(next);
+	}
+
+	std::vector<std::future<TreeStatistics>> results;
+	results.reserve(frontier.size());
+
+	for (const auto& frame : frontier)
+	{
+		results.push_back(pool->submit([&visitSubtree, frame] { return visitSubtree(frame); }));
+	}
+
+	for (auto& result : results)
+	{
+		stats.merge(result.get());
+	}
+
+	return stats;
+}
+
+#endif
@@ -12,6 +12,13 @@ struct UniformRank
 	uint64_t* totalComparisons;
 	uint64_t* firstTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = false;
+
+	uint64_t getValue() const noexcept
+	{
+		return urank;
+	}
+
 	inline int updateComparisons(const UniformRank& other) const noexcept
 	{
 		++(*totalComparisons);
@@ -0,0 +1,283 @@
+#include "Workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace
+{
+	// log1p(x) / x, accurate near 0
+	double log1p_over_x(double x) noexcept
+	{
+		return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+	}
+
+	// expm1(x) / x, accurate near 0
+	double expm1_over_x(double x) noexcept
+	{
+		return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3.0 * (1 + 0.25 * x));
+	}
+
+	/**
+	 * Random keys are redrawn until they are distinct, so that the timed
+	 * inserts never need to check for a present key first.
+	 *
+	 * @return the distinct keys handed out to inserts, in insertion order
+	 */
+	std::vector<unsigned> generate_insert_keys(const WorkloadOptions& options, size_t count, std::mt19937_64& generator)
+	{
+		std::vector<unsigned> keys(count);
+		std::unordered_set<unsigned> seen;
+
+		switch (options.distribution)
+		{
+		case KeyDistribution::Sequential:
+			std::iota(keys.begin(), keys.end(), 0u);
+			break;
+
+		case KeyDistribution::Shuffled:
+			std::iota(keys.begin(), keys.end(), 0u);
+			std::shuffle(keys.begin(), keys.end(), generator);
+			break;
+
+		case KeyDistribution::Uniform:
+		case KeyDistribution::Zipfian:
+		{
+			std::uniform_int_distribution<unsigned> distribution;
+			seen.reserve(count);
+
+			for (auto& key : keys)
+			{
+				do
+				{
+					key = distribution(generator);
+				} while (!seen.insert(key).second);
+			}
+			break;
+		}
+
+		case KeyDistribution::Clustered:
+		{
+			unsigned clusterSize = std::max(options.clusterSize, 1u);
+			std::uniform_int_distribution<unsigned> distribution(0, std::numeric_limits<unsigned>::max() - clusterSize);
+			seen.reserve(count);
+
+			// keys of a cluster overlapping an earlier one are skipped, which
+			// leaves that cluster shorter
+			size_t numKeys = 0;
+			while (numKeys < count)
+			{
+				unsigned start = distribution(generator);
+				for (unsigned offset = 0; offset < clusterSize && numKeys < count; ++offset)
+				{
+					if (seen.insert(start + offset).second)
+					{
+						keys[numKeys++] = start + offset;
+					}
+				}
+			}
+			break;
+		}
+		}
+
+		return keys;
+	}
+}
+
+ZipfDistribution::ZipfDistribution(double exponent): _exponent(exponent)
+{
+	if (!(exponent > 0))
+	{
+		throw std::invalid_argument("Zipf exponent must be positive");
+	}
+
+	_hIntegralX1 = hIntegral(1.5) - 1;
+	_s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+}
+
+uint64_t ZipfDistribution::operator()(uint64_t n, std::mt19937_64& generator) const
+{
+	std::uniform_real_distribution<double> uniform(0, 1);
+	double hIntegralN = hIntegral(n + 0.5);
+
+	while (true)
+	{
+		double u = hIntegralN + uniform(generator) * (_hIntegralX1 - hIntegralN);
+		double x = hIntegralInverse(u);
+		uint64_t k = std::clamp<double>(std::floor(x + 0.5), 1, n);
+
+		if (k - x <= _s || u >= hIntegral(k + 0.5) - h(k))
+		{
+			return k;
+		}
+	}
+}
+
+double ZipfDistribution::h(double x) const noexcept
+{
+	return std::exp(-_exponent * std::log(x));
+}
+
+double ZipfDistribution::hIntegral(double x) const noexcept
+{
+	double logX = std::log(x);
+	return expm1_over_x((1 - _exponent) * logX) * logX;
+}
+
+double ZipfDistribution::hIntegralInverse(double x) const noexcept
+{
+	double t = std::max(x * (1 - _exponent), -1.0);
+	return std::exp(log1p_over_x(t) * x);
+}
+
+Workload generate_workload(const WorkloadOptions& options)
+{
+	std::mt19937_64 generator(options.seed);
+
+	const OperationMix& mix = options.mix;
+	std::discrete_distribution<int> typeDistribution({mix.insert, mix.find, mix.remove, mix.range});
+
+	// pick operation types first, so the number of fresh keys is known
+	Workload workload;
+	workload.operations.resize(options.numOperations);
+
+	size_t numInserts = 0;
+	for (auto& operation : workload.operations)
+	{
+		operation.type = static_cast<OperationType>(typeDistribution(generator));
+		numInserts += operation.type == OperationType::Insert;
+	}
+
+	std::vector<unsigned> insertKeys = generate_insert_keys(options, options.numKeys + numInserts, generator);
+	workload.loadKeys.assign(insertKeys.begin(), insertKeys.begin() + options.numKeys);
+
+	ZipfDistribution zipf(options.zipfExponent);
+	size_t numInserted = options.numKeys;
+
+	for (auto& operation : workload.operations)
+	{
+		if (operation.type == OperationType::Insert)
+		{
+			operation.key = insertKeys[numInserted++];
+		}
+		else if (numInserted == 0)
+		{
+			operation.key = 0;
+		}
+		else if (options.distribution == KeyDistribution::Zipfian)
+		{
+			operation.key = insertKeys[zipf(numInserted, generator) - 1];
+		}
+		else
+		{
+			operation.key = insertKeys[std::uniform_int_distribution<size_t>(0, numInserted - 1)(generator)];
+		}
+	}
+
+	return workload;
+}
+
+KeyDistribution parse_key_distribution(const std::string& name)
+{
+	for (auto distribution : {KeyDistribution::Sequential, KeyDistribution::Shuffled, KeyDistribution::Uniform, KeyDistribution::Zipfian, KeyDistribution::Clustered})
+	{
+		if (to_string(distribution) == name)
+		{
+			return distribution;
+		}
+	}
+
+	throw std::invalid_argument("Unknown key distribution: " + name);
+}
+
+std::string to_string(KeyDistribution distribution)
+{
+	switch (distribution)
+	{
+	case KeyDistribution::Sequential:
+		return "sequential";
+	case KeyDistribution::Shuffled:
+		return "shuffled";
+	case KeyDistribution::Uniform:
+		return "uniform";
+	case KeyDistribution::Zipfian:
+		return "zipfian";
+	case KeyDistribution::Clustered:
+		return "clustered";
+	}
+
+	return "unknown";
+}
+
+std::string to_string(OperationType type)
+{
+	switch (type)
+	{
+	case OperationType::Insert:
+		return "insert";
+	case OperationType::Find:
+		return "find";
+	case OperationType::Remove:
+		return "remove";
+	case OperationType::Range:
+		return "range";
+	}
+
+	return "unknown";
+}
+
+OperationMix parse_operation_mix(const std::string& spec)
+{
+	OperationMix mix;
+	std::istringstream stream(spec);
+	std::string entry;
+
+	while (std::getline(stream, entry, ','))
+	{
+		size_t equals = entry.find('=');
+		if (equals == std::string::npos)
+		{
+			throw std::invalid_argument("Expected operation=weight in mix: " + entry);
+		}
+
+		std::string name = entry.substr(0, equals);
+		double weight = std::stod(entry.substr(equals + 1));
+
+		if (weight < 0)
+		{
+			throw std::invalid_argument("Negative weight in mix: " + entry);
+		}
+
+		if (name == "insert")
+		{
+			mix.insert = weight;
+		}
+		else if (name == "find")
+		{
+			mix.find = weight;
+		}
+		else if (name == "remove")
+		{
+			mix.remove = weight;
+		}
+		else if (name == "range")
+		{
+			mix.range = weight;
+		}
+		else
+		{
+			throw std::invalid_argument("Unknown operation in mix: " + name);
+		}
+	}
+
+	if (mix.insert + mix.find + mix.remove + mix.range <= 0)
+	{
+		throw std::invalid_argument("Operation mix has no positive weights: " + spec);
+	}
+
+	return mix;
+}
@@ -0,0 +1,131 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class KeyDistribution
+{
+	// 0, 1, 2, ... in increasing order
+	Sequential,
+	// a random permutation of 0, 1, 2, ...
+	Shuffled,
+	// uniformly random keys, requests spread uniformly over inserted keys
+	Uniform,
+	// uniformly random keys, requests skewed towards a few hot keys
+	Zipfian,
+	// runs of consecutive keys starting at uniformly random keys
+	Clustered
+};
+
+enum class OperationType : uint8_t
+{
+	Insert,
+	Find,
+	Remove,
+	Range
+};
+
+constexpr unsigned NUM_OPERATION_TYPES = 4;
+
+/**
+ * Relative weights of each operation type; they need not add up to anything.
+ */
+struct OperationMix
+{
+	double insert = 0;
+	double find = 0;
+	double remove = 0;
+	double range = 0;
+};
+
+struct Operation
+{
+	OperationType type;
+	unsigned key;
+};
+
+struct WorkloadOptions
+{
+	KeyDistribution distribution = KeyDistribution::Uniform;
+	OperationMix mix;
+	// keys inserted before the operations start
+	unsigned numKeys = 0;
+	unsigned numOperations = 0;
+	// exponent of the Zipfian request distribution
+	double zipfExponent = 0.99;
+	// consecutive keys per cluster of the clustered distribution
+	unsigned clusterSize = 64;
+	uint64_t seed = 0;
+};
+
+/**
+ * A fully generated workload, so that no time is spent generating keys while
+ * the trees are being timed and every tree can replay exactly the same one.
+ *
+ * Inserts take fresh keys from the key distribution, in order, while finds,
+ * removes and ranges target keys inserted earlier (or attempted), chosen
+ * uniformly or, for the Zipfian distribution, by popularity.
+ */
+struct Workload
+{
+	std::vector<unsigned> loadKeys;
+	std::vector<Operation> operations;
+};
+
+/**
+ * Samples Zipf(s) ranks in [1, n] by rejection-inversion (Hörmann and
+ * Derflinger), which takes constant time and needs no precomputed tables, so
+ * n may change from one sample to the next.
+ */
+class ZipfDistribution
+{
+public:
+	explicit ZipfDistribution(double exponent);
+
+	/**
+	 * @param  n         number of items
+	 * @param  generator source of randomness
+	 * @return           a rank in [1, n], where rank r has probability
+	 *                   proportional to 1 / r^exponent
+	 */
+	uint64_t operator()(uint64_t n, std::mt19937_64& generator) const;
+
+private:
+	double _exponent;
+	double _hIntegralX1;
+	double _s;
+
+	double h(double x) const noexcept;
+	double hIntegral(double x) const noexcept;
+	double hIntegralInverse(double x) const noexcept;
+};
+
+/**
+ * @param  options what to generate
+ * @return         the load keys and operations of a workload
+ */
+Workload generate_workload(const WorkloadOptions& options);
+
+/**
+ * @param  name sequential, shuffled, uniform, zipfian or clustered
+ * @return      the named key distribution
+ * @throws      std::invalid_argument for unknown names
+ */
+KeyDistribution parse_key_distribution(const std::string& name);
+
+std::string to_string(KeyDistribution distribution);
+
+std::string to_string(OperationType type);
+
+/**
+ * @param  spec comma separated weights, e.g. "insert=50,find=40,range=10";
+ *              missing operations get a weight of 0
+ * @return      the described operation mix
+ * @throws      std::invalid_argument for malformed specs
+ */
+OperationMix parse_operation_mix(const std::string& spec);
+
+#endif
@@ -0,0 +1,249 @@
+#include "WriteAheadLog.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	[[noreturn]] void throw_log_errno(const std::string& what)
+	{
+		throw std::runtime_error(what + ": " + std::strerror(errno));
+	}
+
+	uint32_t get_checksum(const char* data, size_t bytes) noexcept
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+		}
+
+		return hash;
+	}
+
+	bool read_fully(int fd, char* data, size_t bytes, size_t offset)
+	{
+		while (bytes > 0)
+		{
+			ssize_t result = ::pread(fd, data, bytes, offset);
+			if (result == -1 && errno == EINTR)
+			{
+				continue;
+			}
+
+			if (result <= 0)
+			{
+				return false;
+			}
+
+			data += result;
+			bytes -= result;
+			offset += result;
+		}
+
+		return true;
+	}
+
+	void write_fully(int fd, const char* data, size_t bytes)
+	{
+		while (bytes > 0)
+		{
+			ssize_t written = ::write(fd, data, bytes);
+			if (written == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				throw_log_errno("Failed to write log");
+			}
+
+			data += written;
+			bytes -= written;
+		}
+	}
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+	}
+}
+
+void WriteAheadLog::open(const std::string& path, Options options, const std::function<void(const char*, size_t)>& onGroup)
+{
+	close();
+
+	_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (_fd == -1)
+	{
+		throw_log_errno("Failed to open log " + path);
+	}
+
+	_options = options;
+	_buffer.assign(GROUP_HEADER_SIZE, 0);
+	_lastSync = std::chrono::steady_clock::now();
+	_unsynced = false;
+
+	struct stat st;
+	if (::fstat(_fd, &st) == -1)
+	{
+		throw_log_errno("Failed to stat log " + path);
+	}
+
+	// replay groups until the first torn one
+	size_t fileSize = st.st_size;
+	size_t offset = 0;
+	std::vector<char> payload;
+
+	while (offset + GROUP_HEADER_SIZE <= fileSize)
+	{
+		char header[GROUP_HEADER_SIZE];
+		if (!read_fully(_fd, header, GROUP_HEADER_SIZE, offset))
+		{
+			break;
+		}
+
+		uint32_t payloadBytes, checksum;
+		std::memcpy(&payloadBytes, header, sizeof(payloadBytes));
+		std::memcpy(&checksum, header + sizeof(payloadBytes), sizeof(checksum));
+
+		if (offset + GROUP_HEADER_SIZE + payloadBytes > fileSize)
+		{
+			break;
+		}
+
+		payload.resize(payloadBytes);
+		if (!read_fully(_fd, payload.data(), payloadBytes, offset + GROUP_HEADER_SIZE) || get_checksum(payload.data(), payloadBytes) != checksum)
+		{
+			break;
+		}
+
+		if (onGroup)
+		{
+			onGroup(payload.data(), payloadBytes);
+		}
+
+		offset += GROUP_HEADER_SIZE + payloadBytes;
+	}
+
+	if (offset != fileSize)
+	{
+		if (::ftruncate(_fd, offset) == -1)
+		{
+			throw_log_errno("Failed to truncate torn log " + path);
+		}
+		fsync();
+	}
+
+	if (::lseek(_fd, offset, SEEK_SET) == -1)
+	{
+		throw_log_errno("Failed to seek log " + path);
+	}
+}
+
+void WriteAheadLog::append(const void* data, size_t bytes)
+{
+	const char* begin = static_cast<const char*>(data);
+	_buffer.insert(_buffer.end(), begin, begin + bytes);
+
+	if (_buffer.size() - GROUP_HEADER_SIZE >= _options.groupCommitBytes)
+	{
+		commit();
+	}
+}
+
+void WriteAheadLog::commit()
+{
+	writeGroup();
+
+	if (_unsynced && std::chrono::steady_clock::now() - _lastSync >= _options.syncInterval)
+	{
+		fsync();
+	}
+}
+
+void WriteAheadLog::sync()
+{
+	writeGroup();
+
+	if (_unsynced)
+	{
+		fsync();
+	}
+}
+
+void WriteAheadLog::reset()
+{
+	_buffer.resize(GROUP_HEADER_SIZE);
+
+	if (::ftruncate(_fd, 0) == -1 || ::lseek(_fd, 0, SEEK_SET) == -1)
+	{
+		throw_log_errno("Failed to reset log");
+	}
+
+	fsync();
+}
+
+void WriteAheadLog::close()
+{
+	if (_fd == -1)
+	{
+		return;
+	}
+
+	int fd = _fd;
+	try
+	{
+		sync();
+	}
+	catch (...)
+	{
+		::close(fd);
+		_fd = -1;
+		throw;
+	}
+
+	::close(fd);
+	_fd = -1;
+}
+
+void WriteAheadLog::writeGroup()
+{
+	uint32_t payloadBytes = _buffer.size() - GROUP_HEADER_SIZE;
+	if (payloadBytes == 0)
+	{
+		return;
+	}
+
+	uint32_t checksum = get_checksum(_buffer.data() + GROUP_HEADER_SIZE, payloadBytes);
+	std::memcpy(_buffer.data(), &payloadBytes, sizeof(payloadBytes));
+	std::memcpy(_buffer.data() + sizeof(payloadBytes), &checksum, sizeof(checksum));
+
+	write_fully(_fd, _buffer.data(), _buffer.size());
+
+	_buffer.resize(GROUP_HEADER_SIZE);
+	_unsynced = true;
+}
+
+void WriteAheadLog::fsync()
+{
+	if (::fdatasync(_fd) == -1)
+	{
+		throw_log_errno("Failed to sync log");
+	}
+
+	_lastSync = std::chrono::steady_clock::now();
+	_unsynced = false;
+}
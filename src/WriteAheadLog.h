@@ -0,0 +1,92 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Append-only binary log with group commit. Appended records are buffered and
+ * written out together as one checksummed group, and fsyncs are batched so at
+ * most one happens per sync interval. A group torn by a crash fails its
+ * checksum, and it and everything after it are discarded when the log is
+ * reopened.
+ *
+ * The log does not interpret records; see DurableZipTree for the record
+ * format used by the zip trees. Failed writes throw std::runtime_error.
+ */
+class WriteAheadLog
+{
+public:
+	struct Options
+	{
+		// buffered bytes that trigger a group commit
+		size_t groupCommitBytes = 64 * 1024;
+		// minimum time between fsyncs when committing groups
+		std::chrono::milliseconds syncInterval = std::chrono::milliseconds(10);
+	};
+
+	WriteAheadLog() = default;
+	~WriteAheadLog();
+
+	WriteAheadLog(const WriteAheadLog&) = delete;
+	WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+	/**
+	 * Opens or creates a log, passing the records of every intact group to
+	 * onGroup in order, and truncates any torn tail so new groups follow the
+	 * last intact one.
+	 *
+	 * @param path    log file
+	 * @param options group commit and fsync batching options
+	 * @param onGroup called with the records of each intact group, may be empty
+	 */
+	void open(const std::string& path, Options options, const std::function<void(const char*, size_t)>& onGroup = nullptr);
+
+	/**
+	 * Buffers a record, committing the group once it is large enough.
+	 *
+	 * @param data  record bytes
+	 * @param bytes record size
+	 */
+	void append(const void* data, size_t bytes);
+
+	/**
+	 * Writes the buffered records as a group, and fsyncs if the sync interval
+	 * has passed since the last fsync. Otherwise the group is only synced by a
+	 * later commit or sync, however long that takes.
+	 */
+	void commit();
+
+	/**
+	 * Writes the buffered records and fsyncs, so every appended record is
+	 * durable once this returns.
+	 */
+	void sync();
+
+	/**
+	 * Drops every record, e.g. once they are all included in a snapshot.
+	 */
+	void reset();
+
+	void close();
+
+private:
+	// bytes of the group header: payload size and payload checksum
+	static constexpr size_t GROUP_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+	int _fd = -1;
+	Options _options;
+	// buffered group, starting with space for its header
+	std::vector<char> _buffer;
+	std::chrono::steady_clock::time_point _lastSync;
+	bool _unsynced = false;
+
+	void writeGroup();
+	void fsync();
+};
+
+#endif
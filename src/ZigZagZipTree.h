@@ -24,9 +24,9 @@ namespace
 	 */
 	uint8_t getRandomRank()
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
-		static std::geometric_distribution<uint8_t> distribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
+		thread_local std::geometric_distribution<uint8_t> distribution(0.5);
 
 		return distribution(generator);
 	}
@@ -183,7 +183,7 @@ bool ZigZagZipTree<KeyType>::remove(const KeyType& key) noexcept
 
 	_head = std::unique_ptr<Node>(removeRecursive(key, _head));
 
-	return prevSize == getSize();
+	return prevSize != getSize();
 }
 
 template <typename KeyType>
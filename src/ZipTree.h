@@ -20,6 +20,13 @@ struct Rank
 	uint64_t* totalComparisons;
 	uint64_t* firstTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return rank;
+	}
+
 	inline int updateComparisons(const Rank& other) const noexcept
 	{
 		// ++(*totalComparisons);
@@ -67,9 +74,9 @@ namespace
 	 */
 	Rank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies)
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
-		static std::geometric_distribution<uint8_t> distribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
+		thread_local std::geometric_distribution<uint8_t> distribution(0.5);
 
 		return {distribution(generator), totalComparisons, firstTies};
 	}
@@ -196,7 +203,7 @@ bool ZipTree<KeyType>::remove(const KeyType& key) noexcept
 
 	_head = std::unique_ptr<Node>(removeRecursive(key, _head));
 
-	return prevSize == _size;
+	return prevSize != _size;
 }
 
 template <typename KeyType>
@@ -207,7 +214,7 @@ typename ZipTree<KeyType>::Node* ZipTree<KeyType>::removeRecursive(const KeyType
 		return root.release();
 	}
 
-	if (key == root->key)
+	if (!(key < root->key) && !(root->key < key))
 	{
 		--_size;
 		return zip(root->left.release(), root->right.release());
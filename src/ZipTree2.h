@@ -12,6 +12,13 @@ struct GeometricRank
 	uint64_t* totalComparisons;
 	uint64_t* firstTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return rank;
+	}
+
 	inline int updateComparisons(const GeometricRank& other) const noexcept
 	{
 		++(*totalComparisons);
@@ -50,11 +57,11 @@ struct GeometricRank
 	}
 };
 
-template <typename KeyType>
-class ZipTree : public GeneralizedZipTree<KeyType, GeometricRank>
+template <typename KeyType, typename Compare = std::less<KeyType>>
+class ZipTree : public GeneralizedZipTree<KeyType, GeometricRank, Compare>
 {
 public:
-	ZipTree(unsigned maxSize) : GeneralizedZipTree<KeyType, GeometricRank>(maxSize) {}
+	ZipTree(unsigned maxSize, const Compare& compare = Compare()) : GeneralizedZipTree<KeyType, GeometricRank, Compare>(maxSize, compare) {}
 
 protected:
 	GeometricRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
@@ -0,0 +1,433 @@
+#ifndef ZIPTREEMAP_H
+#define ZIPTREEMAP_H
+
+#include "GeneralizedZipTree.h"
+
+#include "UniformOpenSSLRandom.h"
+
+#include <utility>
+#include <vector>
+
+struct MapRank
+{
+	uint8_t rank;
+	uint64_t* totalComparisons;
+	uint64_t* firstTies;
+
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return rank;
+	}
+
+	inline int updateComparisons(const MapRank& other) const noexcept
+	{
+		++(*totalComparisons);
+		if (rank == other.rank)
+		{
+			++(*firstTies);
+			return 0;
+		}
+
+		return rank < other.rank ? -1 : 1;
+	}
+
+	bool operator<(const MapRank& other) const noexcept
+	{
+		return updateComparisons(other) < 0;
+	}
+
+	bool operator>(const MapRank& other) const noexcept
+	{
+		return updateComparisons(other) > 0;
+	}
+
+	bool operator==(const MapRank& other) const noexcept
+	{
+		return updateComparisons(other) == 0;
+	}
+
+	bool operator<=(const MapRank& other) const noexcept
+	{
+		return updateComparisons(other) <= 0;
+	}
+
+	bool operator>=(const MapRank& other) const noexcept
+	{
+		return updateComparisons(other) >= 0;
+	}
+};
+
+/**
+ * Ordered key-value map on the array zip tree. Keys and ranks stay in the
+ * buckets, and values live in a separate array at the same indices, so
+ * searches only touch densely packed keys and never the values they pass.
+ *
+ * Unlike the sets, every operation tolerates present and absent keys alike,
+ * and upserts detect an existing key within the same descent that would
+ * insert it: the search runs down to the place a new node would take, and
+ * below that only along the path that unzipping would walk, before anything
+ * is changed.
+ *
+ * Value pointers stay valid until the next insert or erase.
+ */
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+class ZipTreeMap
+{
+public:
+	/**
+	 * @param maxSize number of entries to reserve space for
+	 * @param compare ordering of the keys
+	 */
+	ZipTreeMap(unsigned maxSize, const Compare& compare = Compare()): _index(maxSize, compare)
+	{
+		_index.values.reserve(maxSize);
+	}
+
+	ValueType* find(const KeyType& key) noexcept
+	{
+		return find<KeyType>(key);
+	}
+
+	const ValueType* find(const KeyType& key) const noexcept
+	{
+		return find<KeyType>(key);
+	}
+
+	/**
+	 * @param  key key to look up, of any LookupKey type
+	 * @return     the value of the key, or nullptr if it is absent
+	 */
+	template <LookupKey<KeyType, Compare> K>
+	ValueType* find(const K& key) noexcept
+	{
+		unsigned index = _index.findIndex(key);
+		return index != Index::NULLPTR ? &_index.values[index] : nullptr;
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	const ValueType* find(const K& key) const noexcept
+	{
+		unsigned index = _index.findIndex(key);
+		return index != Index::NULLPTR ? &_index.values[index] : nullptr;
+	}
+
+	bool contains(const KeyType& key) const noexcept
+	{
+		return _index.find(key);
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	bool contains(const K& key) const noexcept
+	{
+		return _index.find(key);
+	}
+
+	/**
+	 * Sets the value of a key, inserting the key if it is absent.
+	 *
+	 * @param  key   key to set
+	 * @param  value new value
+	 * @return       the stored value, and whether the key was inserted
+	 */
+	template <typename V>
+	std::pair<ValueType*, bool> insert_or_assign(const KeyType& key, V&& value)
+	{
+		auto [index, isInserted] = _index.findOrInsert(key, [this, &value] { _index.values.emplace_back(std::forward<V>(value)); });
+		if (!isInserted)
+		{
+			_index.values[index] = std::forward<V>(value);
+		}
+
+		return {&_index.values[index], isInserted};
+	}
+
+	/**
+	 * Inserts a key with a value constructed from args, unless the key is
+	 * present, in which case args are left untouched.
+	 *
+	 * @param  key  key to insert
+	 * @param  args arguments of the value's constructor
+	 * @return      the stored value, and whether the key was inserted
+	 */
+	template <typename... Args>
+	std::pair<ValueType*, bool> try_emplace(const KeyType& key, Args&&... args)
+	{
+		auto [index, isInserted] = _index.findOrInsert(key, [this, &args...] { _index.values.emplace_back(std::forward<Args>(args)...); });
+		return {&_index.values[index], isInserted};
+	}
+
+	/**
+	 * Removes a key and its value, if present.
+	 *
+	 * @param  key key to remove
+	 * @return     true if the key was removed, false otherwise
+	 */
+	bool erase(const KeyType& key) noexcept
+	{
+		return erase<KeyType>(key);
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	bool erase(const K& key) noexcept
+	{
+		if (!_index.remove(key))
+		{
+			return false;
+		}
+
+		// the value of the last bucket was moved into the freed slot
+		_index.values.pop_back();
+		return true;
+	}
+
+	/**
+	 * Calls visit(key, value) for every key within [low, high], in increasing
+	 * order.
+	 *
+	 * @param low   smallest key to visit
+	 * @param high  largest key to visit
+	 * @param visit callback receiving each key and its value
+	 */
+	template <typename Visit>
+	void forEachInRange(const KeyType& low, const KeyType& high, Visit&& visit)
+	{
+		_index.forEachIndexInRange(low, high, [this, &visit](unsigned index) { visit(_index.getKey(index), _index.values[index]); });
+	}
+
+	template <typename Visit>
+	void forEachInRange(const KeyType& low, const KeyType& high, Visit&& visit) const
+	{
+		_index.forEachIndexInRange(low, high, [this, &visit](unsigned index) { visit(_index.getKey(index), std::as_const(_index.values[index])); });
+	}
+
+	/**
+	 * @param  key key to look up
+	 * @return     the copy of the key stored in the map and its value, or two
+	 *             nullptrs if the key is absent
+	 */
+	std::pair<const KeyType*, const ValueType*> findEntry(const KeyType& key) const noexcept
+	{
+		return findEntry<KeyType>(key);
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	std::pair<const KeyType*, const ValueType*> findEntry(const K& key) const noexcept
+	{
+		unsigned index = _index.findIndex(key);
+		if (index == Index::NULLPTR)
+		{
+			return {nullptr, nullptr};
+		}
+
+		return {&_index.getKey(index), &_index.values[index]};
+	}
+
+	unsigned getSize() const noexcept
+	{
+		return _index.getSize();
+	}
+
+	bool empty() const noexcept
+	{
+		return getSize() == 0;
+	}
+
+	int getHeight() const noexcept
+	{
+		return _index.getHeight();
+	}
+
+	TreeStatistics getStatistics(ThreadPool* pool = nullptr) const
+	{
+		return _index.getStatistics(pool);
+	}
+
+	bool setStructuralCounters(StructuralCounters* counters) noexcept
+	{
+		return _index.setStructuralCounters(counters);
+	}
+
+private:
+	/**
+	 * The tree of the keys, with the values in an array parallel to its
+	 * buckets.
+	 */
+	class Index : public GeneralizedZipTree<KeyType, MapRank, Compare>
+	{
+		typedef GeneralizedZipTree<KeyType, MapRank, Compare> Base;
+
+	public:
+		using Base::NULLPTR;
+		using Base::forEachIndexInRange;
+
+		std::vector<ValueType> values;
+
+		Index(unsigned maxSize, const Compare& compare): Base(maxSize, compare)
+		{
+		}
+
+		const KeyType& getKey(unsigned index) const noexcept
+		{
+			return this->_buckets[index].key;
+		}
+
+		/**
+		 * @return index of the bucket with a given key, or NULLPTR
+		 */
+		template <typename K>
+		unsigned findIndex(const K& key) const noexcept
+		{
+			unsigned curIndex = this->_buckets.empty() ? NULLPTR : this->_rootIndex;
+			while (curIndex != NULLPTR)
+			{
+				const auto& cur = this->_buckets[curIndex];
+				if (this->_compare(key, cur.key))
+				{
+					curIndex = cur.left;
+				}
+				else if (this->_compare(cur.key, key))
+				{
+					curIndex = cur.right;
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			return curIndex;
+		}
+
+		/**
+		 * Finds a key, or inserts it with a fresh rank. The value and bucket of
+		 * a new key are added before the key is linked in, and the value is
+		 * removed again if adding the bucket throws, so if either throws, the
+		 * map is left unchanged.
+		 *
+		 * The descent needs a rank before it knows whether the key is
+		 * present, and whether it is doesn't depend on the rank, so a rank
+		 * left unused by a found key is kept for the next insert instead of
+		 * sampling one per call.
+		 *
+		 * @param  key          key to find or insert
+		 * @param  emplaceValue adds the value of a new key to the end of values
+		 * @return              index of the key's bucket, and whether it was
+		 *                      inserted
+		 */
+		template <typename EmplaceValue>
+		std::pair<unsigned, bool> findOrInsert(const KeyType& key, EmplaceValue&& emplaceValue)
+		{
+			if (!_hasSpareRank)
+			{
+				_spareRank = this->sampleRank();
+				_hasSpareRank = true;
+			}
+
+			MapRank rank = _spareRank;
+
+			// counts key comparisons for the structural counters
+			uint64_t keyComparisons = 0;
+			auto less = [this, &keyComparisons](const KeyType& a, const KeyType& b) noexcept
+			{
+				++keyComparisons;
+				return this->_compare(a, b);
+			};
+
+			unsigned curIndex = this->_buckets.empty() ? NULLPTR : this->_rootIndex;
+			unsigned prevIndex = NULLPTR;
+			unsigned searchIndex = NULLPTR;
+
+			// descend to the place of the new node, as insert does
+			while (curIndex != NULLPTR)
+			{
+				const auto& cur = this->_buckets[curIndex];
+				bool isLeft = less(key, cur.key);
+
+				if (!isLeft && !less(cur.key, key))
+				{
+					recordFind(keyComparisons);
+					return {curIndex, false};
+				}
+
+				searchIndex = isLeft ? cur.left : cur.right;
+				if (!(rank < cur.rank || (rank == cur.rank && !isLeft)))
+				{
+					break;
+				}
+
+				prevIndex = curIndex;
+				curIndex = searchIndex;
+			}
+
+			// below it, the key can only be on the path that unzipping walks
+			while (curIndex != NULLPTR && searchIndex != NULLPTR)
+			{
+				const auto& cur = this->_buckets[searchIndex];
+				if (less(key, cur.key))
+				{
+					searchIndex = cur.left;
+				}
+				else if (less(cur.key, key))
+				{
+					searchIndex = cur.right;
+				}
+				else
+				{
+					recordFind(keyComparisons);
+					return {searchIndex, false};
+				}
+			}
+
+			this->bindRank(rank);
+			unsigned xIndex = this->_buckets.size();
+
+			// keep values parallel to the buckets if either one fails to grow
+			emplaceValue();
+			try
+			{
+				this->_buckets.push_back({key, rank});
+			}
+			catch (...)
+			{
+				values.pop_back();
+				throw;
+			}
+
+			_hasSpareRank = false;
+			this->_isRightSpineValid = false;
+
+			this->linkAndUnzip(xIndex, curIndex, prevIndex, keyComparisons);
+			return {xIndex, true};
+		}
+
+	protected:
+		MapRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
+		{
+			return {get_random_geometric(), totalComparisons, firstTies};
+		}
+
+		void onBucketMoved(unsigned from, unsigned to) noexcept override
+		{
+			values[to] = std::move(values[from]);
+		}
+
+	private:
+		// a rank sampled by findOrInsert that no insert has used yet
+		MapRank _spareRank;
+		bool _hasSpareRank = false;
+
+		void recordFind(uint64_t keyComparisons) noexcept
+		{
+			if (this->_structuralCounters != nullptr)
+			{
+				this->_structuralCounters->recordFind(keyComparisons);
+			}
+		}
+	};
+
+	Index _index;
+};
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef ZIPTREEMULTISET_H
+#define ZIPTREEMULTISET_H
+
+#include "ZipTreeMap.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+/**
+ * Ordered multiset on the array zip tree with counted nodes: each distinct
+ * key has one node, and its multiplicity lives in the value array of a
+ * ZipTreeMap. Inserting a key that is already present only bumps its count,
+ * found in the same descent that would have inserted it, so repeated keys
+ * neither allocate nodes nor change the shape of the tree.
+ */
+template <typename KeyType, typename Compare = std::less<KeyType>>
+class ZipTreeMultiset
+{
+public:
+	/**
+	 * @param maxSize number of distinct keys to reserve space for
+	 * @param compare ordering of the keys
+	 */
+	ZipTreeMultiset(unsigned maxSize, const Compare& compare = Compare()): _counts(maxSize, compare)
+	{
+	}
+
+	/**
+	 * Adds copies of a key. Adding no copies leaves the multiset unchanged.
+	 *
+	 * @param  key    key to add
+	 * @param  copies number of copies to add
+	 * @return        number of copies of the key afterwards
+	 */
+	uint64_t insert(const KeyType& key, uint64_t copies = 1)
+	{
+		if (copies == 0)
+		{
+			return count(key);
+		}
+
+		uint64_t& count = *_counts.try_emplace(key, 0).first;
+		count += copies;
+		_size += copies;
+		return count;
+	}
+
+	/**
+	 * Removes copies of a key, by default all of them.
+	 *
+	 * @param  key    key to remove
+	 * @param  copies largest number of copies to remove
+	 * @return        number of copies removed
+	 */
+	uint64_t erase(const KeyType& key, uint64_t copies = std::numeric_limits<uint64_t>::max()) noexcept
+	{
+		uint64_t* count = _counts.find(key);
+		if (count == nullptr)
+		{
+			return 0;
+		}
+
+		if (copies < *count)
+		{
+			*count -= copies;
+			_size -= copies;
+			return copies;
+		}
+
+		uint64_t removed = *count;
+		_counts.erase(key);
+		_size -= removed;
+		return removed;
+	}
+
+	uint64_t count(const KeyType& key) const noexcept
+	{
+		return count<KeyType>(key);
+	}
+
+	/**
+	 * @param  key key to look up, of any LookupKey type
+	 * @return     number of copies of the key
+	 */
+	template <LookupKey<KeyType, Compare> K>
+	uint64_t count(const K& key) const noexcept
+	{
+		const uint64_t* count = _counts.find(key);
+		return count != nullptr ? *count : 0;
+	}
+
+	bool contains(const KeyType& key) const noexcept
+	{
+		return _counts.contains(key);
+	}
+
+	template <LookupKey<KeyType, Compare> K>
+	bool contains(const K& key) const noexcept
+	{
+		return _counts.contains(key);
+	}
+
+	/**
+	 * All copies of a key share one node, so the range of elements equal to a
+	 * key is that node's key and count.
+	 *
+	 * @param  key key to look up
+	 * @return     the stored key and its number of copies, or nullptr and 0 if
+	 *             the key is absent
+	 */
+	std::pair<const KeyType*, uint64_t> equal_range(const KeyType& key) const noexcept
+	{
+		auto [storedKey, copies] = _counts.findEntry(key);
+		return {storedKey, copies != nullptr ? *copies : 0};
+	}
+
+	/**
+	 * @param  low  smallest key to count
+	 * @param  high largest key to count
+	 * @return      number of elements within [low, high], counting copies
+	 */
+	uint64_t countRange(const KeyType& low, const KeyType& high) const
+	{
+		uint64_t total = 0;
+		_counts.forEachInRange(low, high, [&total](const KeyType&, uint64_t count) { total += count; });
+		return total;
+	}
+
+	/**
+	 * Calls visit(key, count) for every distinct key within [low, high], in
+	 * increasing order.
+	 *
+	 * @param low   smallest key to visit
+	 * @param high  largest key to visit
+	 * @param visit callback receiving each key and its number of copies
+	 */
+	template <typename Visit>
+	void forEachInRange(const KeyType& low, const KeyType& high, Visit&& visit) const
+	{
+		_counts.forEachInRange(low, high, visit);
+	}
+
+	/**
+	 * @return number of elements, counting copies
+	 */
+	uint64_t getSize() const noexcept
+	{
+		return _size;
+	}
+
+	/**
+	 * @return number of distinct keys, which is the number of nodes
+	 */
+	unsigned getDistinctSize() const noexcept
+	{
+		return _counts.getSize();
+	}
+
+	bool empty() const noexcept
+	{
+		return _size == 0;
+	}
+
+	int getHeight() const noexcept
+	{
+		return _counts.getHeight();
+	}
+
+	TreeStatistics getStatistics(ThreadPool* pool = nullptr) const
+	{
+		return _counts.getStatistics(pool);
+	}
+
+private:
+	ZipTreeMap<KeyType, uint64_t, Compare> _counts;
+	uint64_t _size = 0;
+};
+
+#endif
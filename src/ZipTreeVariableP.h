@@ -12,6 +12,14 @@ struct GeometricRank
 	uint64_t* totalComparisons;
 	uint64_t* firstTies;
 
+	// small p gives huge ranks, so histogram by bit width instead
+	static constexpr bool HISTOGRAM_BY_VALUE = false;
+
+	uint64_t getValue() const noexcept
+	{
+		return rank;
+	}
+
 	inline int updateComparisons(const GeometricRank& other) const noexcept
 	{
 		++(*totalComparisons);
@@ -50,30 +58,54 @@ struct GeometricRank
 	}
 };
 
-template <typename KeyType>
-class ZipTreeVariableP : public GeneralizedZipTree<KeyType, GeometricRank>
+template <typename KeyType, typename Compare = std::less<KeyType>>
+class ZipTreeVariableP : public GeneralizedZipTree<KeyType, GeometricRank, Compare>
 {
 public:
     // p should be within the range (0, 1)
-	ZipTreeVariableP(unsigned maxSize, double p)
-        : GeneralizedZipTree<KeyType, GeometricRank>(maxSize), p(p)
+	ZipTreeVariableP(unsigned maxSize, double p, const Compare& compare = Compare())
+        : GeneralizedZipTree<KeyType, GeometricRank, Compare>(maxSize, compare), p(p)
     {
         distribution = std::geometric_distribution<uint64_t>(p);
     }
 
     double getP() const noexcept { return p; }
 
+	/**
+	 * Changes the p that ranks of later inserts are drawn with. Existing nodes
+	 * keep their ranks; see rebuild.
+	 *
+	 * @param newP new p, within the range (0, 1)
+	 */
+	void setP(double newP) noexcept
+	{
+		p = newP;
+		distribution = std::geometric_distribution<uint64_t>(p);
+	}
+
+	/**
+	 * Redraws the rank of every node with a new p and relinks the tree in
+	 * place, as if every key had been inserted with the new p.
+	 *
+	 * @param newP new p, within the range (0, 1)
+	 */
+	void rebuild(double newP)
+	{
+		setP(newP);
+		this->rerank();
+	}
+
 protected:
 	GeometricRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
 	{
-        static std::random_device rd;
-		static std::mt19937_64 generator(rd());
+        thread_local std::random_device rd;
+		thread_local std::mt19937_64 generator(rd());
 
 		return {distribution(generator), totalComparisons, firstTies};
 	}
 
 private:
-    const double p;
+    double p;
     mutable std::geometric_distribution<uint64_t> distribution;
 };
 
@@ -23,6 +23,13 @@ struct ZZRank
 	uint64_t* firstTies;
 	uint64_t* bothTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return grank;
+	}
+
 	inline int updateComparisons(const ZZRank& other) const noexcept
 	{
 		// ++(*totalComparisons);
@@ -74,9 +81,9 @@ namespace
 	 */
 	ZZRank getRandomZZRank(uint16_t maxURank, uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) noexcept
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
-		static std::geometric_distribution<uint8_t> gdistribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
+		thread_local std::geometric_distribution<uint8_t> gdistribution(0.5);
 		std::uniform_int_distribution<uint16_t> udistribution(0, maxURank);
 
 		return {gdistribution(generator), udistribution(generator), totalComparisons, firstTies, bothTies};
@@ -208,7 +215,7 @@ bool ZipZipTree<KeyType>::remove(const KeyType& key) noexcept
 
 	_head = std::unique_ptr<Node>(removeRecursive(key, _head));
 
-	return prevSize == _size;
+	return prevSize != _size;
 }
 
 template <typename KeyType>
@@ -219,7 +226,7 @@ typename ZipZipTree<KeyType>::Node* ZipZipTree<KeyType>::removeRecursive(const K
 		return root.release();
 	}
 
-	if (key == root->key)
+	if (!(key < root->key) && !(root->key < key))
 	{
 		--_size;
 		return zip(root->left.release(), root->right.release());
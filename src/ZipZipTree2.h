@@ -14,6 +14,13 @@ struct GeometricUniformRank
 	uint64_t* firstTies;
 	uint64_t* bothTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return grank;
+	}
+
 	inline int updateComparisons(const GeometricUniformRank& other) const noexcept
 	{
 		++(*totalComparisons);
@@ -66,9 +73,9 @@ public:
 protected:
 	GeometricUniformRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
 	{
-		static std::random_device rd;
-		static std::default_random_engine generator(rd());
-		static std::geometric_distribution<uint8_t> gdistribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::default_random_engine generator(rd());
+		thread_local std::geometric_distribution<uint8_t> gdistribution(0.5);
 		std::uniform_int_distribution<uint16_t> udistribution(0, _maxURank);
 
 		return {gdistribution(generator), udistribution(generator), totalComparisons, firstTies, bothTies};
@@ -14,6 +14,13 @@ struct GeometricGeometricRank
 	uint64_t* firstTies;
 	uint64_t* bothTies;
 
+	static constexpr bool HISTOGRAM_BY_VALUE = true;
+
+	uint64_t getValue() const noexcept
+	{
+		return grank1;
+	}
+
 	inline int updateComparisons(const GeometricGeometricRank& other) const noexcept
 	{
 		++(*totalComparisons);
@@ -66,9 +73,9 @@ public:
 protected:
 	GeometricGeometricRank getRandomRank(uint64_t* totalComparisons, uint64_t* firstTies, uint64_t* bothTies) const noexcept override
 	{
-		static std::random_device rd;
-		static std::mt19937 generator(rd());
-		static std::geometric_distribution<uint16_t> gdistribution(0.5);
+		thread_local std::random_device rd;
+		thread_local std::mt19937 generator(rd());
+		thread_local std::geometric_distribution<uint16_t> gdistribution(0.5);
 
 		return {gdistribution(generator), gdistribution(generator), totalComparisons, firstTies, bothTies};
 		// return {get_random_geometric(), get_random_geometric(), totalComparisons, firstTies, bothTies};
@@ -0,0 +1,1573 @@
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
+#include "PTuner.h"
+#include "StreamingStatistics.h"
+#include "ThreadPool.h"
+#include "TreeRegistry.h"
+#include "Workload.h"
+#include "ZipTreeVariableP.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static const std::string DEFAULT_SUMMARY_FILE = "bench-summary.csv";
+static const std::string CONFIGURATION_HEADER = "tree,p,keys,mix_insert,mix_find,mix_remove,mix_range,n";
+static const std::string SUMMARY_GROUP_HEADER = CONFIGURATION_HEADER + ",phase";
+static const std::string CHECKPOINT_MAGIC = "ZIPTREE_BENCH_CHECKPOINT 2";
+static const std::string RAW_HEADER = CONFIGURATION_HEADER + ",trial,seed,phase,operations,ns,inserts,finds,removes,ranges,hits,range_keys,size,height,avg_depth,comparisons,"
+	"cycles,instructions,l1d_misses,llc_misses,branch_misses,dtlb_misses";
+
+struct BenchOptions
+{
+	std::vector<std::string> trees;
+	std::vector<KeyDistribution> distributions = {KeyDistribution::Uniform};
+	std::vector<OperationMix> mixes;
+	std::vector<unsigned> sizes = {1u << 16};
+	// p values to run the variants that use p with
+	std::vector<double> ps = {0.5};
+	// operations per trial, or 0 for as many as there are loaded keys
+	unsigned numOperations = 0;
+	// trials per cell, or on average when the number of trials is adaptive
+	unsigned numTrials = 1;
+	// relative confidence interval half-width to stop at, or 0 to always run
+	// numTrials trials per cell
+	double targetCi = 0;
+	std::string ciMetric = "avg_depth";
+	double confidence = 0.95;
+	unsigned minTrials = 10;
+	// total trials over all cells, or 0 for numTrials per cell
+	uint64_t trialBudget = 0;
+	double zipfExponent = 0.99;
+	unsigned clusterSize = 64;
+	// number of consecutive keys a range operation spans
+	unsigned rangeWidth = 64;
+	uint64_t seed = std::random_device()();
+	std::string summaryPath = DEFAULT_SUMMARY_FILE;
+	// file to append raw per-trial rows to, or empty for none
+	std::string rawPath;
+	std::chrono::milliseconds flushInterval = std::chrono::seconds(10);
+	// file recording the progress of the sweep at every flush, or empty for
+	// none; an existing checkpoint is resumed
+	std::string checkpointPath;
+	// worker threads running trials, 0 for every hardware thread
+	unsigned numThreads = 1;
+	bool pinThreads = false;
+	// count hardware events of each phase with perf_event_open
+	bool perfCounters = false;
+	// time every n-th operation on its own, or none for 0
+	unsigned latencySampling = 0;
+	// count key comparisons, link writes and (un)zip path lengths
+	bool structuralCounters = false;
+	// only report the memory of each tree after loading, instead of trials
+	bool memoryReport = false;
+	// only profile the variable-p zip tree with each p on every workload and
+	// report the cheapest, instead of trials
+	bool tuningReport = false;
+	// only time the branchless descents of the array zip tree against
+	// branching ones, instead of trials
+	bool descentReport = false;
+};
+
+/**
+ * A trial's workload, generated by whichever of the trial's trees needs it
+ * first and then shared by all of them.
+ */
+class SharedWorkload
+{
+public:
+	explicit SharedWorkload(const WorkloadOptions& options): _options(options)
+	{
+	}
+
+	const Workload& get()
+	{
+		std::call_once(_generated, [this] { _workload = generate_workload(_options); });
+		return _workload;
+	}
+
+	const WorkloadOptions& getOptions() const noexcept
+	{
+		return _options;
+	}
+
+private:
+	WorkloadOptions _options;
+	std::once_flag _generated;
+	Workload _workload;
+};
+
+// counts of one timed phase of a trial, and the tree after it
+struct PhaseResult
+{
+	uint64_t operations = 0;
+	uint64_t ns = 0;
+	uint64_t inserts = 0;
+	uint64_t finds = 0;
+	uint64_t removes = 0;
+	uint64_t ranges = 0;
+	// inserted, found or removed keys, and non-empty ranges
+	uint64_t hits = 0;
+	uint64_t rangeKeys = 0;
+	unsigned size = 0;
+	int height = -1;
+	double averageDepth = 0;
+	// rank comparisons made during the phase
+	uint64_t comparisons = 0;
+	// hardware events of the phase, if counted
+	PerfCounts counters;
+	// latencies of the sampled operations by OperationType, in timestamp
+	// counter ticks
+	LatencyHistogram latencies[NUM_OPERATION_TYPES];
+	// structural work of the phase, if the tree counts it
+	std::optional<StructuralCounters> structure;
+};
+
+struct TrialResult
+{
+	// CSV fields of the configuration, matching CONFIGURATION_HEADER
+	std::string configuration;
+	unsigned trial;
+	uint64_t seed;
+	PhaseResult load;
+	PhaseResult run;
+};
+
+void print_usage(const char* program)
+{
+	std::cout << "usage: " << program << " [options]\n"
+		<< "  --trees a,b,...    tree variants to run, or all (default: all)\n"
+		<< "  --keys a,b,...     key distributions: sequential, shuffled, uniform, zipfian, clustered (default: uniform)\n"
+		<< "  --mix spec         operation weights, e.g. insert=50,find=30,remove=10,range=10;\n"
+		<< "                     repeat for several mixes (default: find=100)\n"
+		<< "  --sizes n,m,...    keys loaded before the operations (default: 65536)\n"
+		<< "  --ops count        operations per trial (default: the loaded key count)\n"
+		<< "  --trials count     trials per cell, or per cell on average with --ci (default: 1)\n"
+		<< "  --ci width         stop a cell once the confidence interval of its metric is\n"
+		<< "                     within +-width of its mean (e.g. 0.01), and spend the\n"
+		<< "                     remaining budget on the cells furthest from it\n"
+		<< "  --ci-metric name   metric of the run phase to track: ns_per_op, height,\n"
+		<< "                     avg_depth or comparisons (default: avg_depth)\n"
+		<< "  --confidence value confidence level of the interval (default: 0.95)\n"
+		<< "  --min-trials count trials per cell before checking the interval (default: 10)\n"
+		<< "  --budget count     total trials over all cells (default: trials per cell)\n"
+		<< "  --p a,b,...        p values of the variable-p zip tree (default: 0.5)\n"
+		<< "  --zipf value       exponent of the Zipfian requests (default: 0.99)\n"
+		<< "  --cluster-size n   keys per cluster of the clustered distribution (default: 64)\n"
+		<< "  --range-width n    keys spanned by a range operation (default: 64)\n"
+		<< "  --seed value       base seed; trial t uses seed + t for every tree (default: random)\n"
+		<< "  --output path      summary file, one row per configuration, phase and metric,\n"
+		<< "                     rewritten periodically (default: " << DEFAULT_SUMMARY_FILE << ")\n"
+		<< "  --raw path         also append one row per trial and phase to this file\n"
+		<< "  --flush seconds    time between summary rewrites (default: 10)\n"
+		<< "  --checkpoint path  record finished trials and partial summaries here at every\n"
+		<< "                     rewrite; if the file exists, resume the sweep it records\n"
+		<< "                     (run with the same options, the seed is taken from it)\n"
+		<< "  --threads count    threads running trials in parallel, 0 for all (default: 1);\n"
+		<< "                     concurrent trials share caches and memory bandwidth\n"
+		<< "  --pin              pin each thread to its own CPU\n"
+		<< "  --perf             count cycles, instructions, L1D, LLC and dTLB read misses\n"
+		<< "                     and branch misses of each phase (user space only)\n"
+		<< "  --latency n        time every n-th operation with the timestamp counter and\n"
+		<< "                     report p50, p99, p99.9 and max latency per operation type,\n"
+		<< "                     pooled over the trials of each configuration (default: 0)\n"
+		<< "  --structure        count key comparisons, child link writes and unzip and zip\n"
+		<< "                     path lengths of the trees that support it\n"
+		<< "  --memory           print the bytes per key of every tree after loading each\n"
+		<< "                     size with the first key distribution, instead of trials\n"
+		<< "  --tune             time the variable-p zip tree with every p of --p on each\n"
+		<< "                     workload, replaying each --trials times, and mark the\n"
+		<< "                     cheapest p, instead of trials\n"
+		<< "  --descent          time inserts, finds and depth lookups of the array zip tree\n"
+		<< "                     with branchless descents over unsigned keys against the\n"
+		<< "                     same tree descending with branches, on each workload,\n"
+		<< "                     --trials times, instead of trials; --perf adds branch\n"
+		<< "                     misses\n"
+		<< "\nregistered trees:";
+
+	for (const auto& [name, factory] : get_tree_registry())
+	{
+		std::cout << " " << name;
+	}
+
+	std::cout << std::endl;
+}
+
+std::vector<std::string> split_list(const std::string& list)
+{
+	std::vector<std::string> items;
+	std::istringstream stream(list);
+	std::string item;
+
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
+		}
+	}
+
+	return items;
+}
+
+BenchOptions parse_options(int argc, char* argv[])
+{
+	BenchOptions options;
+	std::vector<std::string> trees = {"all"};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+
+		if (option == "--help" || option == "-h")
+		{
+			print_usage(argv[0]);
+			std::exit(0);
+		}
+
+		if (option == "--pin")
+		{
+			options.pinThreads = true;
+			continue;
+		}
+
+		if (option == "--perf")
+		{
+			options.perfCounters = true;
+			continue;
+		}
+
+		if (option == "--structure")
+		{
+			options.structuralCounters = true;
+			continue;
+		}
+
+		if (option == "--memory")
+		{
+			options.memoryReport = true;
+			continue;
+		}
+
+		if (option == "--tune")
+		{
+			options.tuningReport = true;
+			continue;
+		}
+
+		if (option == "--descent")
+		{
+			options.descentReport = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+		{
+			throw std::invalid_argument("Missing value for " + option);
+		}
+
+		std::string value = argv[++i];
+
+		if (option == "--trees")
+		{
+			trees = split_list(value);
+		}
+		else if (option == "--keys")
+		{
+			options.distributions.clear();
+			for (const auto& name : split_list(value))
+			{
+				options.distributions.push_back(parse_key_distribution(name));
+			}
+		}
+		else if (option == "--mix")
+		{
+			options.mixes.push_back(parse_operation_mix(value));
+		}
+		else if (option == "--sizes")
+		{
+			options.sizes.clear();
+			for (const auto& size : split_list(value))
+			{
+				options.sizes.push_back(std::stoul(size));
+			}
+		}
+		else if (option == "--ops")
+		{
+			options.numOperations = std::stoul(value);
+		}
+		else if (option == "--trials")
+		{
+			options.numTrials = std::stoul(value);
+		}
+		else if (option == "--ci")
+		{
+			options.targetCi = std::stod(value);
+		}
+		else if (option == "--ci-metric")
+		{
+			if (value != "ns_per_op" && value != "height" && value != "avg_depth" && value != "comparisons")
+			{
+				throw std::invalid_argument("Unknown metric " + value);
+			}
+			options.ciMetric = value;
+		}
+		else if (option == "--confidence")
+		{
+			options.confidence = std::stod(value);
+			if (!(options.confidence > 0 && options.confidence < 1))
+			{
+				throw std::invalid_argument("Confidence must be within (0, 1)");
+			}
+		}
+		else if (option == "--min-trials")
+		{
+			options.minTrials = std::max<unsigned long>(std::stoul(value), 2);
+		}
+		else if (option == "--budget")
+		{
+			options.trialBudget = std::stoull(value);
+		}
+		else if (option == "--p")
+		{
+			options.ps.clear();
+			for (const auto& p : split_list(value))
+			{
+				options.ps.push_back(std::stod(p));
+			}
+		}
+		else if (option == "--zipf")
+		{
+			options.zipfExponent = std::stod(value);
+		}
+		else if (option == "--cluster-size")
+		{
+			options.clusterSize = std::stoul(value);
+		}
+		else if (option == "--range-width")
+		{
+			options.rangeWidth = std::max<unsigned long>(std::stoul(value), 1);
+		}
+		else if (option == "--seed")
+		{
+			options.seed = std::stoull(value);
+		}
+		else if (option == "--output")
+		{
+			options.summaryPath = value;
+		}
+		else if (option == "--raw")
+		{
+			options.rawPath = value;
+		}
+		else if (option == "--flush")
+		{
+			options.flushInterval = std::chrono::milliseconds(static_cast<int64_t>(std::stod(value) * 1000));
+		}
+		else if (option == "--checkpoint")
+		{
+			options.checkpointPath = value;
+		}
+		else if (option == "--latency")
+		{
+			options.latencySampling = std::stoul(value);
+		}
+		else if (option == "--threads")
+		{
+			options.numThreads = std::stoul(value);
+		}
+		else
+		{
+			throw std::invalid_argument("Unknown option " + option);
+		}
+	}
+
+	const TreeRegistry& registry = get_tree_registry();
+	for (const auto& tree : trees)
+	{
+		if (tree == "all")
+		{
+			for (const auto& [name, factory] : registry)
+			{
+				options.trees.push_back(name);
+			}
+		}
+		else if (registry.count(tree) == 0)
+		{
+			throw std::invalid_argument("Unknown tree " + tree);
+		}
+		else
+		{
+			options.trees.push_back(tree);
+		}
+	}
+
+	if (options.mixes.empty())
+	{
+		options.mixes.push_back(parse_operation_mix("find=100"));
+	}
+
+	return options;
+}
+
+PhaseResult run_load(BinarySearchTree<unsigned>& tree, const std::vector<unsigned>& keys, PerfCounters* counters, unsigned latencySampling)
+{
+	PhaseResult result;
+	unsigned countdown = latencySampling;
+
+	if (counters != nullptr)
+	{
+		counters->start();
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned key : keys)
+	{
+		bool isSampled = countdown != 0 && --countdown == 0;
+		uint64_t begin = isSampled ? read_timestamp_counter() : 0;
+
+		// load keys are distinct, so every insert adds an absent key
+		tree.insert(key);
+
+		if (isSampled)
+		{
+			result.latencies[static_cast<unsigned>(OperationType::Insert)].record(read_timestamp_counter() - begin);
+			countdown = latencySampling;
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	if (counters != nullptr)
+	{
+		result.counters = counters->stop();
+	}
+
+	result.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	result.operations = keys.size();
+	result.inserts = keys.size();
+	result.hits = keys.size();
+	return result;
+}
+
+PhaseResult run_operations(BinarySearchTree<unsigned>& tree, const std::vector<Operation>& operations, unsigned rangeWidth, PerfCounters* counters, unsigned latencySampling)
+{
+	PhaseResult result;
+	unsigned countdown = latencySampling;
+
+	if (counters != nullptr)
+	{
+		counters->start();
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto& operation : operations)
+	{
+		// time every latencySampling-th operation, if any
+		bool isSampled = countdown != 0 && --countdown == 0;
+		uint64_t begin = isSampled ? read_timestamp_counter() : 0;
+
+		switch (operation.type)
+		{
+		case OperationType::Insert:
+			++result.inserts;
+			// insert keys are distinct and never handed out again, so every
+			// insert adds an absent key
+			tree.insert(operation.key);
+			++result.hits;
+			break;
+
+		case OperationType::Find:
+			++result.finds;
+			result.hits += tree.find(operation.key);
+			break;
+
+		case OperationType::Remove:
+			++result.removes;
+			result.hits += tree.remove(operation.key);
+			break;
+
+		case OperationType::Range:
+		{
+			++result.ranges;
+			unsigned high = operation.key + std::min(rangeWidth - 1, ~operation.key);
+			unsigned count = tree.countRange(operation.key, high);
+			result.hits += count > 0;
+			result.rangeKeys += count;
+			break;
+		}
+		}
+
+		if (isSampled)
+		{
+			result.latencies[static_cast<unsigned>(operation.type)].record(read_timestamp_counter() - begin);
+			countdown = latencySampling;
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	if (counters != nullptr)
+	{
+		result.counters = counters->stop();
+	}
+
+	result.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	result.operations = operations.size();
+	return result;
+}
+
+/**
+ * Records the state of the tree after a phase.
+ *
+ * @param result            result of the phase
+ * @param tree              tree the phase ran on
+ * @param comparisonsBefore rank comparisons made before the phase
+ */
+void record_tree_state(PhaseResult& result, const BinarySearchTree<unsigned>& tree, uint64_t comparisonsBefore)
+{
+	TreeStatistics stats = tree.getStatistics();
+	result.size = tree.getSize();
+	result.height = stats.height;
+	// a phase may leave the tree empty, whose average depth is taken as 0,
+	// like ns_per_op of a phase without operations
+	result.averageDepth = result.size > 0 ? stats.getAverageDepth() : 0;
+	result.comparisons = tree.getTotalComparisons() - comparisonsBefore;
+}
+
+void save_raw_result(std::ostream& raw, const TrialResult& trial, const std::string& phase, const PhaseResult& result)
+{
+	raw << trial.configuration << "," << trial.trial << "," << trial.seed << "," << phase << "," << result.operations << "," << result.ns << ","
+		<< result.inserts << "," << result.finds << "," << result.removes << "," << result.ranges << ","
+		<< result.hits << "," << result.rangeKeys << "," << result.size << "," << result.height << "," << result.averageDepth << "," << result.comparisons;
+
+	// events that weren't counted are left empty
+	for (unsigned i = 0; i < PerfCounts::NUM_EVENTS; ++i)
+	{
+		raw << ",";
+		if (result.counters.isAvailable(static_cast<PerfCounts::Event>(i)))
+		{
+			raw << result.counters.values[i];
+		}
+	}
+
+	raw << "\n";
+}
+
+void aggregate_result(StatisticsAggregator& aggregator, const TrialResult& trial, const std::string& phase, const PhaseResult& result)
+{
+	std::string group = trial.configuration + "," + phase;
+
+	aggregator.add(group, "ns_per_op", result.operations > 0 ? static_cast<double>(result.ns) / result.operations : 0);
+	aggregator.add(group, "hits", result.hits);
+	aggregator.add(group, "size", result.size);
+	aggregator.add(group, "height", result.height);
+	aggregator.add(group, "avg_depth", result.averageDepth);
+	aggregator.add(group, "comparisons", result.comparisons);
+
+	for (unsigned i = 0; i < PerfCounts::NUM_EVENTS; ++i)
+	{
+		auto event = static_cast<PerfCounts::Event>(i);
+		if (result.counters.isAvailable(event) && result.operations > 0)
+		{
+			aggregator.add(group, std::string(PerfCounts::getName(event)) + "_per_op", static_cast<double>(result.counters.values[i]) / result.operations);
+		}
+	}
+
+	if (result.structure && result.operations > 0)
+	{
+		const StructuralCounters& structure = *result.structure;
+		double operations = result.operations;
+
+		aggregator.add(group, "key_comparisons_per_op", structure.keyComparisons / operations);
+		aggregator.add(group, "link_writes_per_op", structure.linkWrites / operations);
+		aggregator.add(group, "bucket_moves_per_op", structure.bucketMoves / operations);
+
+		for (const auto& [name, lengths] : {std::pair<std::string, const std::vector<uint64_t>*>{"unzip_length", &structure.unzipLengths}, {"zip_length", &structure.zipLengths}})
+		{
+			if (!lengths->empty())
+			{
+				aggregator.add(group, name, StructuralCounters::getMean(*lengths));
+				aggregator.add(group, name + "_p99", StructuralCounters::getQuantile(*lengths, 0.99));
+				aggregator.add(group, name + "_max", lengths->size() - 1);
+			}
+		}
+	}
+}
+
+/**
+ * One (tree, p, keys, mix, n) configuration, whose trials are summarized
+ * together.
+ */
+struct Cell
+{
+	std::string name;
+	TreeParameters parameters;
+	// CSV fields of the configuration, matching CONFIGURATION_HEADER
+	std::string configuration;
+	size_t workloadIndex;
+	unsigned numScheduled = 0;
+	unsigned numFinished = 0;
+	bool converged = false;
+};
+
+/**
+ * One (keys, mix, n) workload configuration and the cells running it.
+ */
+struct WorkloadConfiguration
+{
+	std::string description;
+	// options of trial 0; trial t uses seed + t
+	WorkloadOptions options;
+	std::vector<size_t> cells;
+};
+
+/**
+ * Lists every workload configuration and cell described by the options.
+ *
+ * @param options   benchmark options
+ * @param workloads receives the workload configurations
+ * @param cells     receives the cells
+ */
+void enumerate_cells(const BenchOptions& options, std::vector<WorkloadConfiguration>& workloads, std::vector<Cell>& cells)
+{
+	const TreeRegistry& registry = get_tree_registry();
+
+	for (unsigned n : options.sizes)
+	{
+		unsigned numOperations = options.numOperations != 0 ? options.numOperations : n;
+
+		for (auto distribution : options.distributions)
+		{
+			for (const auto& mix : options.mixes)
+			{
+				WorkloadConfiguration workload;
+				workload.description = to_string(distribution) + ": n = " + std::to_string(n);
+				workload.options.distribution = distribution;
+				workload.options.mix = mix;
+				workload.options.numKeys = n;
+				workload.options.numOperations = numOperations;
+				workload.options.zipfExponent = options.zipfExponent;
+				workload.options.clusterSize = options.clusterSize;
+				workload.options.seed = options.seed;
+
+				for (const auto& name : options.trees)
+				{
+					bool usesP = registry.at(name).usesP;
+					std::vector<double> ps = usesP ? options.ps : std::vector<double>{0.5};
+
+					for (double p : ps)
+					{
+						Cell cell;
+						cell.name = name;
+						cell.parameters.maxSize = n + numOperations;
+						cell.parameters.p = p;
+						cell.workloadIndex = workloads.size();
+
+						std::ostringstream configuration;
+						configuration << name << ",";
+						if (usesP)
+						{
+							configuration << p;
+						}
+						configuration << "," << to_string(distribution) << "," << mix.insert << "," << mix.find << "," << mix.remove << "," << mix.range << "," << n;
+						cell.configuration = configuration.str();
+
+						workload.cells.push_back(cells.size());
+						cells.push_back(std::move(cell));
+					}
+				}
+
+				workloads.push_back(std::move(workload));
+			}
+		}
+	}
+}
+
+/**
+ * Runs one trial of one cell on its own thread, with its own tree.
+ *
+ * @return the trial's results
+ */
+TrialResult run_trial(const Cell& cell, SharedWorkload& sharedWorkload, unsigned trial, const BenchOptions& options)
+{
+	const Workload& workload = sharedWorkload.get();
+	auto tree = get_tree_registry().at(cell.name).factory(cell.parameters);
+
+	// counters only count the thread that opens them
+	std::optional<PerfCounters> counters;
+	if (options.perfCounters)
+	{
+		counters.emplace();
+	}
+	PerfCounters* phaseCounters = counters ? &*counters : nullptr;
+
+	TrialResult result;
+	result.configuration = cell.configuration;
+	result.trial = trial;
+	result.seed = sharedWorkload.getOptions().seed;
+
+	// counted separately for each phase
+	StructuralCounters structure[2];
+	bool isCountingStructure = options.structuralCounters && tree->setStructuralCounters(&structure[0]);
+
+	result.load = run_load(*tree, workload.loadKeys, phaseCounters, options.latencySampling);
+	record_tree_state(result.load, *tree, 0);
+
+	uint64_t comparisons = tree->getTotalComparisons();
+	if (isCountingStructure)
+	{
+		tree->setStructuralCounters(&structure[1]);
+	}
+
+	result.run = run_operations(*tree, workload.operations, options.rangeWidth, phaseCounters, options.latencySampling);
+	record_tree_state(result.run, *tree, comparisons);
+
+	if (isCountingStructure)
+	{
+		tree->setStructuralCounters(nullptr);
+		result.load.structure = std::move(structure[0]);
+		result.run.structure = std::move(structure[1]);
+	}
+
+	return result;
+}
+
+/**
+ * Loads one tree per cell of the first key distribution and mix, and prints
+ * its memory usage per key as CSV. The trees are built one at a time, so the
+ * report is not skewed by other trees sharing the heap.
+ */
+void run_memory_report(const std::vector<WorkloadConfiguration>& workloads, const std::vector<Cell>& cells, size_t numWorkloadsPerSize)
+{
+	std::cout << "tree,p,n,bytes_per_key,used_bytes_per_key,key_bytes,rank_bytes,link_bytes,padding_bytes,slack_bytes,headroom_bytes" << std::endl;
+
+	for (size_t i = 0; i < workloads.size(); i += numWorkloadsPerSize)
+	{
+		Workload workload = generate_workload(workloads[i].options);
+
+		for (size_t cellIndex : workloads[i].cells)
+		{
+			const Cell& cell = cells[cellIndex];
+			auto tree = get_tree_registry().at(cell.name).factory(cell.parameters);
+			run_load(*tree, workload.loadKeys, nullptr, 0);
+
+			MemoryUsage usage = tree->memoryUsage();
+			double n = tree->getSize();
+
+			std::cout << cell.name << ",";
+			if (get_tree_registry().at(cell.name).usesP)
+			{
+				std::cout << cell.parameters.p;
+			}
+			std::cout << "," << tree->getSize() << "," << usage.getTotal() / n << "," << usage.getUsed() / n << "," << usage.keys / n << "," << usage.ranks / n << ","
+				<< usage.links / n << "," << usage.padding / n << "," << usage.allocatorSlack / n << "," << usage.capacityHeadroom / n << std::endl;
+		}
+	}
+}
+
+/**
+ * Profiles every p of the options on each workload with a PTuner, replaying
+ * the workload's operations after loading its keys, and prints the cost per
+ * operation of each p as CSV.
+ */
+void run_tuning_report(const BenchOptions& options, const std::vector<WorkloadConfiguration>& workloads)
+{
+	PTunerOptions tunerOptions;
+	tunerOptions.candidates = options.ps;
+	tunerOptions.numRepetitions = options.numTrials;
+	tunerOptions.rangeWidth = options.rangeWidth;
+	PTuner tuner(tunerOptions);
+
+	std::cout << "p,keys,mix_insert,mix_find,mix_remove,mix_range,n,ns_per_op,cheapest" << std::endl;
+
+	for (const auto& configuration : workloads)
+	{
+		const WorkloadOptions& workloadOptions = configuration.options;
+		Workload workload = generate_workload(workloadOptions);
+
+		std::vector<PCost> costs = tuner.profile(workload.loadKeys, workload.operations);
+		double cheapestP = PTuner::getCheapest(costs).p;
+
+		for (const auto& cost : costs)
+		{
+			const OperationMix& mix = workloadOptions.mix;
+			std::cout << cost.p << "," << to_string(workloadOptions.distribution) << "," << mix.insert << "," << mix.find << "," << mix.remove << "," << mix.range << ","
+				<< workloadOptions.numKeys << "," << cost.nsPerOperation << "," << (cost.p == cheapestP) << std::endl;
+		}
+	}
+}
+
+/**
+ * An unsigned key that isn't arithmetic, so the array zip tree descends over
+ * it with branches, as it does for every key type that isn't arithmetic.
+ */
+struct BranchingKey
+{
+	unsigned value;
+
+	bool operator<(const BranchingKey& other) const noexcept
+	{
+		return value < other.value;
+	}
+};
+
+// time per operation of each phase of a descent benchmark
+struct DescentTimes
+{
+	double insertNs = 0;
+	double findNs = 0;
+	double depthNs = 0;
+	double findBranchMisses = 0;
+	bool hasBranchMisses = false;
+};
+
+/**
+ * Builds an array zip tree from keys and ranks, then looks up every lookup
+ * key with find and with getDepth, timing each phase.
+ *
+ * @param keys     distinct keys to insert
+ * @param ranks    rank of each key, so that trees of either key type have the
+ *                 same shape
+ * @param lookups  keys to look up
+ * @param counters counters of the find phase, or nullptr
+ */
+template <typename KeyType>
+DescentTimes time_descents(const std::vector<unsigned>& keys, const std::vector<GeometricRank>& ranks, const std::vector<unsigned>& lookups, PerfCounters* counters)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	auto nsPer = [](Clock::time_point start, Clock::time_point end, size_t count)
+	{
+		return std::chrono::duration<double, std::nano>(end - start).count() / std::max<size_t>(count, 1);
+	};
+
+	DescentTimes times;
+	ZipTreeVariableP<KeyType> tree(keys.size(), 0.5);
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		tree.insert(KeyType{keys[i]}, ranks[i]);
+	}
+	times.insertNs = nsPer(start, Clock::now(), keys.size());
+
+	// sinks the results, so the lookups aren't optimized away
+	[[maybe_unused]] volatile uint64_t sink = 0;
+
+	if (counters != nullptr)
+	{
+		counters->start();
+	}
+
+	start = Clock::now();
+	uint64_t hits = 0;
+	for (unsigned key : lookups)
+	{
+		hits += tree.find(KeyType{key});
+	}
+	auto end = Clock::now();
+
+	if (counters != nullptr)
+	{
+		PerfCounts counts = counters->stop();
+		if (counts.isAvailable(PerfCounts::BranchMisses))
+		{
+			times.findBranchMisses = static_cast<double>(counts.values[PerfCounts::BranchMisses]) / std::max<size_t>(lookups.size(), 1);
+			times.hasBranchMisses = true;
+		}
+	}
+
+	times.findNs = nsPer(start, end, lookups.size());
+	sink = hits;
+
+	start = Clock::now();
+	int64_t depths = 0;
+	for (unsigned key : lookups)
+	{
+		depths += tree.getDepth(KeyType{key});
+	}
+	times.depthNs = nsPer(start, Clock::now(), lookups.size());
+	sink = depths;
+
+	return times;
+}
+
+/**
+ * Times the branchless descents the array zip tree uses for arithmetic keys
+ * against the branching ones it uses for other keys, on trees of identical
+ * shape: one of unsigned keys and one of BranchingKeys, built from the same
+ * keys and ranks. The keys of every operation of a workload are looked up,
+ * whatever its type. Prints the mean time per operation of each phase over
+ * the trials as CSV.
+ */
+void run_descent_report(const BenchOptions& options, const std::vector<WorkloadConfiguration>& workloads)
+{
+	std::optional<PerfCounters> counters;
+	if (options.perfCounters)
+	{
+		counters.emplace();
+	}
+
+	std::cout << "descent,keys,mix_insert,mix_find,mix_remove,mix_range,n,lookups,insert_ns,find_ns,depth_ns,find_branch_misses" << std::endl;
+
+	for (const auto& configuration : workloads)
+	{
+		const WorkloadOptions& workloadOptions = configuration.options;
+		Workload workload = generate_workload(workloadOptions);
+
+		std::vector<unsigned> keys;
+		std::unordered_set<unsigned> seen;
+		for (unsigned key : workload.loadKeys)
+		{
+			if (seen.insert(key).second)
+			{
+				keys.push_back(key);
+			}
+		}
+
+		std::vector<unsigned> lookups;
+		lookups.reserve(workload.operations.size());
+		for (const Operation& operation : workload.operations)
+		{
+			lookups.push_back(operation.key);
+		}
+
+		DescentTimes totals[2];
+		for (unsigned trial = 0; trial < options.numTrials; ++trial)
+		{
+			ZipTreeVariableP<unsigned> rankSource(0, 0.5);
+			std::vector<GeometricRank> ranks;
+			ranks.reserve(keys.size());
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				ranks.push_back(rankSource.sampleRank());
+			}
+
+			DescentTimes times[2] = {
+				time_descents<unsigned>(keys, ranks, lookups, counters ? &*counters : nullptr),
+				time_descents<BranchingKey>(keys, ranks, lookups, counters ? &*counters : nullptr)
+			};
+
+			for (unsigned i = 0; i < 2; ++i)
+			{
+				totals[i].insertNs += times[i].insertNs / options.numTrials;
+				totals[i].findNs += times[i].findNs / options.numTrials;
+				totals[i].depthNs += times[i].depthNs / options.numTrials;
+				totals[i].findBranchMisses += times[i].findBranchMisses / options.numTrials;
+				totals[i].hasBranchMisses = times[i].hasBranchMisses;
+			}
+		}
+
+		const char* names[2] = {"branchless", "branching"};
+		for (unsigned i = 0; i < 2; ++i)
+		{
+			const OperationMix& mix = workloadOptions.mix;
+			std::cout << names[i] << "," << to_string(workloadOptions.distribution) << "," << mix.insert << "," << mix.find << "," << mix.remove << "," << mix.range << ","
+				<< keys.size() << "," << lookups.size() << "," << totals[i].insertNs << "," << totals[i].findNs << "," << totals[i].depthNs << ",";
+			if (totals[i].hasBranchMisses)
+			{
+				std::cout << totals[i].findBranchMisses;
+			}
+			std::cout << std::endl;
+		}
+	}
+}
+
+/**
+ * Progress of an interrupted sweep, as recorded by ResultSink.
+ */
+struct Checkpoint
+{
+	uint64_t seed;
+	// raw file and its size at the checkpoint; later rows are run again
+	std::string rawPath;
+	uint64_t rawBytes;
+	// finished trials per cell configuration
+	std::unordered_map<std::string, unsigned> numFinished;
+	// latencies pooled over the finished trials, by (group, operation type)
+	std::map<std::pair<std::string, std::string>, LatencyHistogram> latencies;
+	// state of the aggregator, as written by saveState
+	std::string statistics;
+};
+
+/**
+ * @param  path       checkpoint file
+ * @param  checkpoint receives the checkpoint
+ * @return            false if there is no checkpoint yet
+ */
+bool load_checkpoint(const std::string& path, Checkpoint& checkpoint)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::string magic;
+	std::getline(file, magic);
+	if (magic != CHECKPOINT_MAGIC)
+	{
+		throw std::runtime_error(path + " is not a benchmark checkpoint");
+	}
+
+	size_t numCells;
+	file >> checkpoint.seed >> checkpoint.rawBytes;
+	file.ignore();
+	std::getline(file, checkpoint.rawPath);
+	file >> numCells;
+
+	for (size_t i = 0; i < numCells; ++i)
+	{
+		unsigned numFinished;
+		std::string configuration;
+		file >> numFinished;
+		file.ignore();
+		std::getline(file, configuration);
+		checkpoint.numFinished[configuration] = numFinished;
+	}
+
+	size_t numHistograms;
+	file >> numHistograms;
+	file.ignore();
+
+	for (size_t i = 0; i < numHistograms && file; ++i)
+	{
+		std::string group, operation;
+		std::getline(file, group, '\t');
+		std::getline(file, operation, '\t');
+		checkpoint.latencies[{group, operation}].load(file);
+		file.ignore();
+	}
+
+	if (!file)
+	{
+		throw std::runtime_error("Truncated checkpoint " + path);
+	}
+
+	std::ostringstream statistics;
+	statistics << file.rdbuf();
+	checkpoint.statistics = statistics.str();
+	return true;
+}
+
+/**
+ * Folds finished trials into the summary (and raw rows, if any) and counts
+ * them per cell. Sampled latencies are pooled over every trial of a cell, and
+ * their percentiles are those of the pooled histogram rather than a mean of
+ * per-trial percentiles. Whenever the summary is rewritten, the finished trials of
+ * every cell and the aggregator state are also written to the checkpoint
+ * file, if any, so an interrupted sweep loses at most one flush interval of
+ * trials. Each cell's trials must be added in trial order.
+ */
+class ResultSink
+{
+public:
+	/**
+	 * @param latencies latencies pooled by an interrupted sweep, if resuming
+	 */
+	ResultSink(const BenchOptions& options, std::vector<Cell>& cells, StatisticsAggregator& aggregator, std::ofstream* raw,
+		std::map<std::pair<std::string, std::string>, LatencyHistogram> latencies = {})
+		: _options(options), _cells(cells), _aggregator(aggregator), _raw(raw), _latencies(std::move(latencies))
+	{
+	}
+
+	StatisticsAggregator& getAggregator() noexcept
+	{
+		return _aggregator;
+	}
+
+	void add(size_t cellIndex, const TrialResult& trial)
+	{
+		aggregate_result(_aggregator, trial, "load", trial.load);
+		aggregate_result(_aggregator, trial, "run", trial.run);
+		poolLatencies(trial, "load", trial.load);
+		poolLatencies(trial, "run", trial.run);
+
+		if (_raw != nullptr)
+		{
+			save_raw_result(*_raw, trial, "load", trial.load);
+			save_raw_result(*_raw, trial, "run", trial.run);
+		}
+
+		++_cells[cellIndex].numFinished;
+
+		if (_aggregator.flushIfDue())
+		{
+			saveCheckpoint();
+		}
+	}
+
+	void flush()
+	{
+		_aggregator.flush();
+		saveCheckpoint();
+	}
+
+private:
+	const BenchOptions& _options;
+	std::vector<Cell>& _cells;
+	StatisticsAggregator& _aggregator;
+	std::ofstream* _raw;
+	std::map<std::pair<std::string, std::string>, LatencyHistogram> _latencies;
+
+	void poolLatencies(const TrialResult& trial, const std::string& phase, const PhaseResult& result)
+	{
+		std::string group = trial.configuration + "," + phase;
+		double nsPerTick = get_ns_per_tick();
+
+		for (unsigned i = 0; i < NUM_OPERATION_TYPES; ++i)
+		{
+			if (result.latencies[i].getCount() == 0)
+			{
+				continue;
+			}
+
+			std::string prefix = to_string(static_cast<OperationType>(i));
+			LatencyHistogram& latencies = _latencies[{group, prefix}];
+			latencies.merge(result.latencies[i]);
+
+			_aggregator.set(group, prefix + "_p50_ns", latencies.getQuantile(0.5) * nsPerTick);
+			_aggregator.set(group, prefix + "_p99_ns", latencies.getQuantile(0.99) * nsPerTick);
+			_aggregator.set(group, prefix + "_p999_ns", latencies.getQuantile(0.999) * nsPerTick);
+			_aggregator.set(group, prefix + "_max_ns", latencies.getMax() * nsPerTick);
+		}
+	}
+
+	void saveCheckpoint()
+	{
+		if (_options.checkpointPath.empty())
+		{
+			return;
+		}
+
+		uint64_t rawBytes = 0;
+		if (_raw != nullptr)
+		{
+			_raw->flush();
+			rawBytes = std::filesystem::file_size(_options.rawPath);
+		}
+
+		std::string tempPath = _options.checkpointPath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::trunc);
+			file << CHECKPOINT_MAGIC << "\n" << _options.seed << " " << rawBytes << "\n" << _options.rawPath << "\n" << _cells.size() << "\n";
+
+			for (const auto& cell : _cells)
+			{
+				file << cell.numFinished << " " << cell.configuration << "\n";
+			}
+
+			file << _latencies.size() << "\n";
+			for (const auto& [key, latencies] : _latencies)
+			{
+				file << key.first << "\t" << key.second << "\t";
+				latencies.save(file);
+				file << "\n";
+			}
+
+			_aggregator.saveState(file);
+
+			if (!file.flush())
+			{
+				throw std::runtime_error("Failed to write checkpoint " + tempPath);
+			}
+		}
+
+		// sync and rename, so a crash leaves the previous or this checkpoint
+		int fd = ::open(tempPath.c_str(), O_RDONLY);
+		if (fd == -1 || ::fsync(fd) == -1)
+		{
+			int error = errno;
+			if (fd != -1)
+			{
+				::close(fd);
+			}
+			throw std::runtime_error("Failed to sync checkpoint " + tempPath + ": " + std::strerror(error));
+		}
+		::close(fd);
+
+		if (std::rename(tempPath.c_str(), _options.checkpointPath.c_str()) != 0)
+		{
+			throw std::runtime_error("Failed to rename checkpoint to " + _options.checkpointPath + ": " + std::strerror(errno));
+		}
+	}
+};
+
+/**
+ * Runs the same number of trials for every cell on a thread pool, then folds
+ * the results into the sink in a fixed order, so the output only depends on
+ * the options and not on the order trials finish in. Trials a resumed cell
+ * already finished are skipped.
+ */
+void run_fixed_trials(const BenchOptions& options, const std::vector<WorkloadConfiguration>& workloads, std::vector<Cell>& cells, ResultSink& sink)
+{
+	ThreadPool pool(options.numThreads, options.pinThreads);
+	std::vector<std::vector<std::pair<size_t, std::future<TrialResult>>>> results(workloads.size());
+
+	for (size_t i = 0; i < workloads.size(); ++i)
+	{
+		for (unsigned trial = 0; trial < options.numTrials; ++trial)
+		{
+			WorkloadOptions workloadOptions = workloads[i].options;
+			workloadOptions.seed += trial;
+
+			// every tree replays the same workload within a trial
+			auto workload = std::make_shared<SharedWorkload>(workloadOptions);
+
+			for (size_t cellIndex : workloads[i].cells)
+			{
+				if (trial < cells[cellIndex].numFinished)
+				{
+					continue;
+				}
+
+				results[i].emplace_back(cellIndex, pool.submit([&cell = cells[cellIndex], workload, trial, &options]
+				{
+					return run_trial(cell, *workload, trial, options);
+				}));
+			}
+		}
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (size_t i = 0; i < workloads.size(); ++i)
+	{
+		for (auto& [cellIndex, future] : results[i])
+		{
+			sink.add(cellIndex, future.get());
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << workloads[i].description << " done after " << (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0) << " seconds" << std::endl;
+	}
+}
+
+/**
+ * @param  confidence two-sided confidence level, within (0, 1)
+ * @return            z such that a standard normal lies within [-z, z] with
+ *                    the given probability
+ */
+double get_normal_quantile(double confidence)
+{
+	double low = 0, high = 40;
+	for (int i = 0; i < 100; ++i)
+	{
+		double middle = (low + high) / 2;
+		(std::erf(middle / std::sqrt(2.0)) < confidence ? low : high) = middle;
+	}
+
+	return (low + high) / 2;
+}
+
+/**
+ * Runs trials for each cell only until the confidence interval of the
+ * tracked metric is narrow enough, and spends the rest of the trial budget
+ * on the cells whose intervals are furthest from the target.
+ *
+ * Every cell first gets minTrials trials. After that, a cell with mean m,
+ * standard deviation s and n trials needs about (z s / (target m))^2 trials in
+ * total, and the next trial always goes to the cell missing the most. Results
+ * are folded in as they arrive, so their order depends on scheduling.
+ */
+void run_adaptive_trials(const BenchOptions& options, const std::vector<WorkloadConfiguration>& workloads, std::vector<Cell>& cells, ResultSink& sink)
+{
+	ThreadPool pool(options.numThreads, options.pinThreads);
+	StatisticsAggregator& aggregator = sink.getAggregator();
+
+	double z = get_normal_quantile(options.confidence);
+	uint64_t budget = options.trialBudget != 0 ? options.trialBudget : cells.size() * options.numTrials;
+	// trials of a resumed sweep count towards its budget
+	uint64_t numScheduled = 0;
+	for (const auto& cell : cells)
+	{
+		numScheduled += cell.numScheduled;
+	}
+	// enough queued trials to keep every worker busy while results are folded in
+	size_t maxInFlight = 2 * pool.getNumThreads();
+
+	std::deque<std::pair<size_t, std::future<TrialResult>>> inFlight;
+
+	auto schedule = [&](size_t cellIndex)
+	{
+		Cell& cell = cells[cellIndex];
+		unsigned trial = cell.numScheduled++;
+		++numScheduled;
+
+		WorkloadOptions workloadOptions = workloads[cell.workloadIndex].options;
+		workloadOptions.seed += trial;
+
+		inFlight.emplace_back(cellIndex, pool.submit([&cell, workloadOptions, trial, &options]
+		{
+			SharedWorkload workload(workloadOptions);
+			return run_trial(cell, workload, trial, options);
+		}));
+	};
+
+	// additional trials a cell is estimated to need, beyond those scheduled
+	auto get_missing_trials = [&](const Cell& cell) -> double
+	{
+		const MetricSummary* summary = aggregator.find(cell.configuration + ",run", options.ciMetric);
+		const RunningStatistics& statistics = summary->statistics;
+
+		double halfWidth = options.targetCi * std::abs(statistics.getMean());
+		double needed = halfWidth > 0 ? std::pow(z * statistics.getStandardDeviation() / halfWidth, 2) : std::numeric_limits<double>::infinity();
+
+		return needed - cell.numScheduled;
+	};
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto check_convergence = [&](Cell& cell)
+	{
+		if (cell.numFinished < options.minTrials || cell.converged)
+		{
+			return;
+		}
+
+		const RunningStatistics& statistics = aggregator.find(cell.configuration + ",run", options.ciMetric)->statistics;
+
+		if (z * statistics.getStandardError() <= options.targetCi * std::abs(statistics.getMean()))
+		{
+			cell.converged = true;
+
+			auto end = std::chrono::high_resolution_clock::now();
+			std::cout << cell.configuration << " converged after " << cell.numFinished << " trials, " << (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0) << " seconds in" << std::endl;
+		}
+	};
+
+	for (size_t i = 0; i < cells.size(); ++i)
+	{
+		check_convergence(cells[i]);
+
+		while (cells[i].numScheduled < options.minTrials && numScheduled < budget)
+		{
+			schedule(i);
+		}
+	}
+
+	// a resumed sweep may have nothing in flight yet, so top up before waiting
+	auto schedule_neediest = [&]
+	{
+		while (inFlight.size() < maxInFlight && numScheduled < budget)
+		{
+			size_t neediest = cells.size();
+			double mostMissing = 0;
+
+			for (size_t i = 0; i < cells.size(); ++i)
+			{
+				const Cell& candidate = cells[i];
+				if (candidate.converged || candidate.numFinished < options.minTrials)
+				{
+					continue;
+				}
+
+				// an unconverged cell with nothing in flight always gets a trial
+				double missing = std::max(get_missing_trials(candidate), candidate.numScheduled == candidate.numFinished ? 1.0 : 0.0);
+				if (missing > mostMissing)
+				{
+					neediest = i;
+					mostMissing = missing;
+				}
+			}
+
+			if (neediest == cells.size())
+			{
+				break;
+			}
+
+			schedule(neediest);
+		}
+	};
+
+	schedule_neediest();
+
+	while (!inFlight.empty())
+	{
+		size_t cellIndex = inFlight.front().first;
+		TrialResult trial = inFlight.front().second.get();
+		inFlight.pop_front();
+
+		sink.add(cellIndex, trial);
+		check_convergence(cells[cellIndex]);
+
+		// hand the freed slots to the cells missing the most trials
+		schedule_neediest();
+	}
+
+	size_t numConverged = std::count_if(cells.begin(), cells.end(), [](const Cell& cell) { return cell.converged; });
+	std::cout << numConverged << " of " << cells.size() << " cells converged using " << numScheduled << " of " << budget << " trials" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+
+	try
+	{
+		options = parse_options(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (options.perfCounters)
+	{
+		PerfCounters probe;
+		for (unsigned i = 0; i < PerfCounts::NUM_EVENTS; ++i)
+		{
+			if (!(probe.getAvailable() & (1u << i)))
+			{
+				std::cerr << "Warning: " << PerfCounts::getName(static_cast<PerfCounts::Event>(i)) << " cannot be counted here" << std::endl;
+			}
+		}
+	}
+
+	if (options.memoryReport)
+	{
+		std::vector<WorkloadConfiguration> workloads;
+		std::vector<Cell> cells;
+		enumerate_cells(options, workloads, cells);
+
+		run_memory_report(workloads, cells, options.distributions.size() * options.mixes.size());
+		return 0;
+	}
+
+	if (options.tuningReport)
+	{
+		std::vector<WorkloadConfiguration> workloads;
+		std::vector<Cell> cells;
+		enumerate_cells(options, workloads, cells);
+
+		run_tuning_report(options, workloads);
+		return 0;
+	}
+
+	if (options.descentReport)
+	{
+		std::vector<WorkloadConfiguration> workloads;
+		std::vector<Cell> cells;
+		enumerate_cells(options, workloads, cells);
+
+		run_descent_report(options, workloads);
+		return 0;
+	}
+
+	if (options.latencySampling != 0)
+	{
+		// calibrate before any trial is timed
+		get_ns_per_tick();
+	}
+
+	StatisticsAggregator aggregator(options.summaryPath, SUMMARY_GROUP_HEADER, options.flushInterval);
+	Checkpoint checkpoint;
+	bool isResuming = false;
+
+	try
+	{
+		isResuming = !options.checkpointPath.empty() && load_checkpoint(options.checkpointPath, checkpoint);
+		if (isResuming)
+		{
+			std::istringstream statistics(checkpoint.statistics);
+			aggregator.loadState(statistics);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	if (isResuming)
+	{
+		// resumed trials must replay the workloads of the interrupted sweep
+		options.seed = checkpoint.seed;
+
+		// drop raw rows of trials finished after the checkpoint, which run again
+		if (!options.rawPath.empty() && options.rawPath == checkpoint.rawPath && std::filesystem::exists(options.rawPath)
+			&& std::filesystem::file_size(options.rawPath) > checkpoint.rawBytes)
+		{
+			std::filesystem::resize_file(options.rawPath, checkpoint.rawBytes);
+		}
+	}
+
+	std::ofstream raw;
+	if (!options.rawPath.empty())
+	{
+		// a new file starts with the header, appended runs only add rows
+		bool isNewFile = !std::filesystem::exists(options.rawPath) || std::filesystem::file_size(options.rawPath) == 0;
+
+		raw.open(options.rawPath, std::ios::app);
+		if (!raw)
+		{
+			std::cerr << "Failed to open " << options.rawPath << std::endl;
+			return 1;
+		}
+
+		if (isNewFile)
+		{
+			raw << RAW_HEADER << "\n";
+		}
+	}
+
+	std::vector<WorkloadConfiguration> workloads;
+	std::vector<Cell> cells;
+	enumerate_cells(options, workloads, cells);
+
+	if (isResuming)
+	{
+		uint64_t numResumed = 0;
+		for (auto& cell : cells)
+		{
+			auto it = checkpoint.numFinished.find(cell.configuration);
+			if (it != checkpoint.numFinished.end())
+			{
+				cell.numScheduled = cell.numFinished = it->second;
+				numResumed += it->second;
+			}
+		}
+
+		std::cout << "Resuming " << options.checkpointPath << " with seed " << options.seed << ": " << numResumed << " trials already done" << std::endl;
+	}
+
+	ResultSink sink(options, cells, aggregator, raw.is_open() ? &raw : nullptr, std::move(checkpoint.latencies));
+
+	if (options.targetCi > 0)
+	{
+		run_adaptive_trials(options, workloads, cells, sink);
+	}
+	else
+	{
+		run_fixed_trials(options, workloads, cells, sink);
+	}
+
+	sink.flush();
+
+	return 0;
+}
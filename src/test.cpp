@@ -10,6 +10,17 @@
 // #include "DynamicZipTree2.h"
 
 #include "ZipTreeVariableP.h"
+#include "DurableZipTree.h"
+#include "SlidingWindowIndex.h"
+#include "ZipTreeMap.h"
+#include "ZipTreeMultiset.h"
+#include "StringZipTree.h"
+
+// rank policies of the pointer trees, for the simulated experiments
+#include "ZipTree.h"
+#include "ZipZipTree.h"
+#include "ShapeSimulator.h"
+#include "PSweep.h"
 
 #include <algorithm>
 #include <string>
@@ -17,23 +28,35 @@
 #include <fstream>
 #include <sstream>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <map>
 #include <random>
 #include <vector>
 #include <stdio.h>
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include <set>
 #include <utility>
+#include <sys/wait.h>
+#include <unistd.h>
 
 static const std::string DATA_FILE_DIRECTORY = "datajournal/";
 static const std::string NORMAL_FILE_NAME = "n-ns-min-med-max-height-avg-";
 static const std::string SQRT_FILE_NAME = "n-ns-min-med-max-height-sqrt-";
 // total comparisons, first tie, both ties
 static const std::string COMPARISON_NORMAL_FILE_NAME = "n-ns-min-med-max-height-avg-tc-ft-bt.csv";
+static const std::string P_SWEEP_FILE_NAME = "p-sweep-";
 static const std::string DYNAMIC_FILE_NAME = "random-n-ns-min-med-max-height-avg-tc-ft-bt-mgb-agb-mub-aub.csv";
 static const std::string DEPTH_FILE_NAME = "n-ns-depths.csv";
 static const std::string VARIABLE_P_FILE_NAME = "n-ns-min-med-max-height-avg-root-rank-p.csv";
+static const std::string SIMULATED_FILE_NAME = "simulated-n-ns-min-med-max-height-avg-root-rank-p.csv";
+// trials of the variable-p sweep finished so far, per computer name
+static const std::string SWEEP_PROGRESS_FILE_NAME = "sweep-progress-";
 
 
 // create unordered map of BinarySearchTree types
@@ -82,6 +105,12 @@ void save_variable_p_data(const std::string& computer_name, unsigned n, size_t n
 	data_file << n << "," << ns << "," << min << "," << med << "," << max << "," << height << "," << avg << "," << root_rank << "," << p << std::endl;
 }
 
+void save_simulated_data(const std::string& ziptree_type, uint64_t n, size_t ns, const ShapeStatistics& shape, double p)
+{
+	std::ofstream data_file(DATA_FILE_DIRECTORY + ziptree_type + "/" + SIMULATED_FILE_NAME, std::ios::app);
+	data_file << n << "," << ns << "," << shape.minKeyDepth << "," << shape.medianKeyDepth << "," << shape.maxKeyDepth << "," << shape.height << "," << shape.getAverageDepth() << "," << shape.rootRank << "," << p << std::endl;
+}
+
 void run_comparison_experiment(const std::string& ziptree_type, unsigned n)
 {
 	auto tree = BST_MAP.at(ziptree_type)(n);
@@ -92,11 +121,12 @@ void run_comparison_experiment(const std::string& ziptree_type, unsigned n)
 		tree->insert(i);
 	}
 
-	unsigned height = tree->getHeight();
+	TreeStatistics stats = tree->getStatistics();
+	unsigned height = stats.height;
 	unsigned min_val_depth = tree->getDepth(0);
 	unsigned med_val_depth = tree->getDepth(n / 2);
 	unsigned max_val_depth = tree->getDepth(n - 1);
-	double average_height = tree->getAverageHeight();
+	double average_height = stats.getAverageDepth();
 	uint64_t total_comparisons = tree->getTotalComparisons();
 	uint64_t first_tie = tree->getFirstTies();
 	uint64_t both_tie = tree->getBothTies();
@@ -175,11 +205,12 @@ void run_normal_experiment(const std::string& ziptree_type, unsigned n, const st
 	// double average_height = tree.getAverageHeight();
 
 
-	unsigned height = tree->getHeight();
+	TreeStatistics stats = tree->getStatistics();
+	unsigned height = stats.height;
 	unsigned min_val_depth = tree->getDepth(0);
 	unsigned med_val_depth = tree->getDepth(n / 2);
 	unsigned max_val_depth = tree->getDepth(n - 1);
-	double average_height = tree->getAverageHeight();
+	double average_height = stats.getAverageDepth();
 
 	auto end = std::chrono::high_resolution_clock::now();
 	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -200,16 +231,49 @@ void run_variable_p_experiment(const std::string& computer_name, unsigned n, dou
 	auto end = std::chrono::high_resolution_clock::now();
 	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
 
-	unsigned height = tree.getHeight();
+	TreeStatistics stats = tree.getStatistics();
+	unsigned height = stats.height;
 	unsigned min_val_depth = tree.getDepth(0);
 	unsigned med_val_depth = tree.getDepth(n / 2);
 	unsigned max_val_depth = tree.getDepth(n - 1);
-	double average_height = tree.getAverageHeight();
+	double average_height = stats.getAverageDepth();
 	uint64_t root_rank = tree.getRootRank().rank;
 
 	save_variable_p_data(computer_name, n, elapsed.count(), min_val_depth, med_val_depth, max_val_depth, height, average_height, root_rank, p);
 }
 
+/**
+ * Measures the shape a tree of the keys 0, ..., n - 1 would have, streaming
+ * its ranks through a ShapeSimulator instead of building it, so n is only
+ * limited by time.
+ */
+template <typename RankType, typename SampleRank>
+void run_simulated_experiment(const std::string& ziptree_type, uint64_t n, double p, SampleRank&& sample_rank)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	ShapeStatistics shape = simulate_shape<RankType>(n, sample_rank);
+	auto end = std::chrono::high_resolution_clock::now();
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+
+	save_simulated_data(ziptree_type, n, elapsed.count(), shape, p);
+}
+
+void run_simulated_experiments(uint64_t n, double p)
+{
+	uint64_t total_comparisons = 0, first_ties = 0, both_ties = 0;
+
+	run_simulated_experiment<Rank>("original", n, 0.5, [&] { return getRandomRank(&total_comparisons, &first_ties); });
+
+	// as chosen by the ZipZipTree constructor, saturating the 16-bit uniform
+	// part from n = 2^41 on
+	uint16_t max_u_rank = std::min<double>(std::pow(static_cast<unsigned>(std::log2(n)), 3), std::numeric_limits<uint16_t>::max());
+	run_simulated_experiment<ZZRank>("zipzip", n, 0.5, [&] { return getRandomZZRank(max_u_rank, &total_comparisons, &first_ties, &both_ties); });
+
+	// an empty tree only serves as the rank distribution
+	ZipTreeVariableP<unsigned> ranks(0, p);
+	run_simulated_experiment<GeometricRank>("variable-p", n, p, [&] { return ranks.sampleRank(); });
+}
+
 // void run_sqrt_experiment(const std::string& ziptree_type, unsigned sqrtn, const std::string& computer_name)
 // {
 // 	unsigned n = sqrtn * sqrtn;
@@ -259,10 +323,7 @@ void run_variable_p_experiment(const std::string& computer_name, unsigned n, dou
 // 	std::vector<unsigned> depths;
 // 	depths.reserve(n);
 
-// 	for (unsigned i = 0; i < n; ++i)
-// 	{
-// 		depths[i] = tree->getDepth(i);
-// 	}
+// 	tree->depthProfile([&depths](const unsigned& key, unsigned depth, uint64_t rank) { depths.push_back(depth); });
 
 // 	auto end = std::chrono::high_resolution_clock::now();
 // 	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
@@ -297,6 +358,550 @@ void run_experiments(unsigned num_trials, unsigned min_n, unsigned max_n, const
 }
 
 
+/**
+ * Reads how far an earlier run of the variable-p sweep got, so a run killed
+ * and restarted (as runexperiments.sh does) picks up where it stopped.
+ *
+ * @return number of trials already finished, or 0 if there is no progress
+ *         file or it was written for a different n or number of trials
+ */
+unsigned load_sweep_progress(const std::string& path, unsigned n, unsigned num_trials)
+{
+	std::ifstream file(path);
+	unsigned saved_n = 0, saved_num_trials = 0, completed = 0;
+
+	if (!(file >> saved_n >> saved_num_trials >> completed) || saved_n != n || saved_num_trials != num_trials)
+	{
+		return 0;
+	}
+
+	return completed;
+}
+
+void save_sweep_progress(const std::string& path, unsigned n, unsigned num_trials, unsigned completed)
+{
+	// write aside and rename, so a kill never leaves a partial count
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path, std::ios::trunc);
+		file << n << " " << num_trials << " " << completed << std::endl;
+	}
+
+	std::filesystem::rename(temp_path, path);
+}
+
+/**
+ * Regression check for ranks loaded from a snapshot, which keep the counter
+ * pointers of the tree that saved them: finger inserts into the reloaded tree
+ * must neither find its keys in the wrong place nor count comparisons into
+ * the saving tree, which is kept alive here so that doing so is observable
+ * rather than a use after free.
+ *
+ * @return true if the check passed
+ */
+bool run_snapshot_regression(unsigned n, double p)
+{
+	std::string path = (std::filesystem::temp_directory_path() / "ziptree-snapshot-regression.bin").string();
+
+	ZipTreeVariableP<unsigned> saved(n, p);
+	for (unsigned i = 0; i < n; ++i)
+	{
+		saved.fingerInsert(2 * i);
+	}
+	saved.saveSnapshot(path);
+
+	ZipTreeVariableP<unsigned> loaded(2 * n, p);
+	loaded.openSnapshot(path, 2 * n);
+	std::filesystem::remove(path);
+
+	uint64_t saved_comparisons = saved.getTotalComparisons();
+	for (unsigned i = 0; i < n; ++i)
+	{
+		loaded.fingerInsert(2 * n + i);
+	}
+
+	bool passed = saved.getTotalComparisons() == saved_comparisons && loaded.getSize() == 2 * n;
+	for (unsigned i = 0; i < n && passed; ++i)
+	{
+		passed = loaded.find(2 * i) && loaded.find(2 * n + i);
+	}
+
+	return passed;
+}
+
+/**
+ * Crash recovery check for DurableZipTree: a child process logs random
+ * inserts and removes of keys below n, checkpointing halfway, then syncs and
+ * exits without closing anything. The tree recovered from its snapshot and
+ * log must hold exactly the keys the child left.
+ *
+ * @return true if the check passed
+ */
+bool run_recovery_check(unsigned n, double p)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+	std::string snapshot_path = (directory / "ziptree-recovery.snapshot").string();
+	std::string log_path = (directory / "ziptree-recovery.log").string();
+	std::filesystem::remove(snapshot_path);
+	std::filesystem::remove(log_path);
+
+	// both processes draw the same operations from the same seed
+	static constexpr unsigned SEED = 12345;
+	unsigned num_operations = 2 * n;
+
+	pid_t pid = ::fork();
+	if (pid == 0)
+	{
+		DurableZipTree<ZipTreeVariableP<unsigned>> tree(snapshot_path, log_path, WriteAheadLog::Options(), n, p);
+		std::mt19937 generator(SEED);
+
+		for (unsigned i = 0; i < num_operations; ++i)
+		{
+			unsigned key = generator() % n;
+			if (generator() % 3 == 0)
+			{
+				tree.remove(key);
+			}
+			else
+			{
+				tree.insert(key);
+			}
+
+			tree.commit();
+			if (i == num_operations / 2)
+			{
+				tree.checkpoint();
+			}
+		}
+
+		tree.sync();
+		::_exit(0);
+	}
+
+	int status = 0;
+	if (pid == -1 || ::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		return false;
+	}
+
+	std::set<unsigned> expected;
+	std::mt19937 generator(SEED);
+	for (unsigned i = 0; i < num_operations; ++i)
+	{
+		unsigned key = generator() % n;
+		if (generator() % 3 == 0)
+		{
+			expected.erase(key);
+		}
+		else
+		{
+			expected.insert(key);
+		}
+	}
+
+	bool passed;
+	{
+		DurableZipTree<ZipTreeVariableP<unsigned>> tree(snapshot_path, log_path, WriteAheadLog::Options(), n, p);
+		const auto& recovered = tree.getTree();
+
+		passed = tree.getNumReplayed() > 0 && recovered.getSize() == expected.size();
+		for (unsigned key = 0; key < n && passed; ++key)
+		{
+			passed = recovered.find(key) == (expected.count(key) == 1);
+		}
+	}
+
+	std::filesystem::remove(snapshot_path);
+	std::filesystem::remove(log_path);
+	return passed;
+}
+
+/**
+ * Checks a SlidingWindowIndex against a std::deque of the same keys: random
+ * runs of pushBack and popFront grow the window to random sizes of up to n / 2
+ * keys and shrink it, down to empty, so the popped prefix is compacted away
+ * many times. Every operation checks the ends of the window, and lookups,
+ * finger lookups, range counts and a full in-order walk are checked along the
+ * way.
+ *
+ * @return true if the check passed
+ */
+bool run_window_check(unsigned n, double p)
+{
+	SlidingWindowIndex<ZipTreeVariableP<unsigned>> window(n, p);
+	std::deque<unsigned> expected;
+	std::mt19937 generator(12345);
+
+	unsigned next_key = 0;
+	unsigned target_size = 0;
+	unsigned num_operations = 8 * n;
+
+	for (unsigned i = 0; i < num_operations; ++i)
+	{
+		if (expected.size() == target_size)
+		{
+			target_size = generator() % (n / 2 + 1);
+		}
+
+		// mostly move towards the target size, sometimes away from it
+		bool grow = expected.size() < target_size ? generator() % 4 != 0 : generator() % 4 == 0;
+		if (grow && expected.size() < n / 2)
+		{
+			next_key += 1 + generator() % 3;
+			window.pushBack(next_key);
+			expected.push_back(next_key);
+		}
+		else
+		{
+			window.popFront();
+			if (!expected.empty())
+			{
+				expected.pop_front();
+			}
+		}
+
+		if (window.getSize() != expected.size() || window.empty() != expected.empty()
+			|| (!expected.empty() && (window.front() != expected.front() || window.back() != expected.back())))
+		{
+			return false;
+		}
+
+		// keys around the window, including some that were never in it
+		unsigned low = expected.empty() ? next_key : expected.front();
+		unsigned key = low + generator() % (next_key - low + 3);
+		bool is_present = std::binary_search(expected.begin(), expected.end(), key);
+		if (window.find(key) != is_present || window.fingerFind(key) != is_present)
+		{
+			return false;
+		}
+
+		unsigned high = key + generator() % 64;
+		size_t count = std::upper_bound(expected.begin(), expected.end(), high) - std::lower_bound(expected.begin(), expected.end(), key);
+		if (window.countRange(key, high) != count)
+		{
+			return false;
+		}
+
+		if (i % (n / 4 + 1) == 0)
+		{
+			std::vector<unsigned> keys;
+			window.forEachInRange(0u, next_key, [&keys](const unsigned& visited) { keys.push_back(visited); });
+			if (!std::equal(keys.begin(), keys.end(), expected.begin(), expected.end()))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Checks a ZipTreeMap against a std::map with random upserts, emplaces,
+ * erases and lookups of keys below n, so that both present and absent keys
+ * are hit often and erases keep moving buckets and their values. The map's
+ * entries are walked in order and compared every n operations.
+ *
+ * @return true if the check passed
+ */
+bool run_map_check(unsigned n)
+{
+	ZipTreeMap<unsigned, uint64_t> map(n);
+	std::map<unsigned, uint64_t> expected;
+	std::mt19937_64 generator(12345);
+
+	unsigned num_operations = 8 * n;
+	for (unsigned i = 0; i < num_operations; ++i)
+	{
+		unsigned key = generator() % n;
+		uint64_t value = generator();
+
+		switch (generator() % 4)
+		{
+			case 0:
+			{
+				auto [stored, is_inserted] = map.insert_or_assign(key, value);
+				bool is_expected_inserted = expected.insert_or_assign(key, value).second;
+				if (*stored != value || is_inserted != is_expected_inserted)
+				{
+					return false;
+				}
+				break;
+			}
+			case 1:
+			{
+				auto [stored, is_inserted] = map.try_emplace(key, value);
+				auto [it, is_expected_inserted] = expected.try_emplace(key, value);
+				if (*stored != it->second || is_inserted != is_expected_inserted)
+				{
+					return false;
+				}
+				break;
+			}
+			case 2:
+			{
+				if (map.erase(key) != (expected.erase(key) == 1))
+				{
+					return false;
+				}
+				break;
+			}
+			default:
+			{
+				auto it = expected.find(key);
+				const uint64_t* found = map.find(key);
+				auto [entry_key, entry_value] = map.findEntry(key);
+				bool is_present = it != expected.end();
+
+				if ((found != nullptr) != is_present || map.contains(key) != is_present || (entry_key != nullptr) != is_present
+					|| (is_present && (*found != it->second || *entry_key != key || *entry_value != it->second)))
+				{
+					return false;
+				}
+				break;
+			}
+		}
+
+		if (map.getSize() != expected.size())
+		{
+			return false;
+		}
+
+		if (i % n == 0)
+		{
+			auto it = expected.begin();
+			bool matches = true;
+			map.forEachInRange(0u, n, [&](const unsigned& visited_key, const uint64_t& visited_value)
+			{
+				matches = matches && it != expected.end() && it->first == visited_key && it->second == visited_value;
+				++it;
+			});
+
+			if (!matches || it != expected.end())
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Checks a ZipTreeMultiset against a std::multiset with random inserts and
+ * erases of several copies at once, including none and all of them, of keys
+ * below n, and with lookups and range counts along the way. The distinct keys
+ * and their counts are walked in order and compared every n operations.
+ *
+ * @return true if the check passed
+ */
+bool run_multiset_check(unsigned n)
+{
+	ZipTreeMultiset<unsigned> multiset(n);
+	std::multiset<unsigned> expected;
+	std::mt19937 generator(12345);
+
+	unsigned num_operations = 8 * n;
+	for (unsigned i = 0; i < num_operations; ++i)
+	{
+		unsigned key = generator() % n;
+
+		switch (generator() % 4)
+		{
+			case 0:
+			{
+				uint64_t copies = generator() % 4;
+				for (uint64_t j = 0; j < copies; ++j)
+				{
+					expected.insert(key);
+				}
+
+				if (multiset.insert(key, copies) != expected.count(key))
+				{
+					return false;
+				}
+				break;
+			}
+			case 1:
+			{
+				// all copies half of the time
+				uint64_t copies = generator() % 2 == 0 ? std::numeric_limits<uint64_t>::max() : generator() % 4;
+				uint64_t removed = 0;
+				for (auto it = expected.find(key); it != expected.end() && *it == key && removed < copies; ++removed)
+				{
+					it = expected.erase(it);
+				}
+
+				if (multiset.erase(key, copies) != removed)
+				{
+					return false;
+				}
+				break;
+			}
+			case 2:
+			{
+				unsigned high = key + generator() % 16;
+				uint64_t count = std::distance(expected.lower_bound(key), expected.upper_bound(high));
+				if (multiset.countRange(key, high) != count)
+				{
+					return false;
+				}
+				break;
+			}
+			default:
+			{
+				uint64_t count = expected.count(key);
+				auto [stored_key, copies] = multiset.equal_range(key);
+				if (multiset.count(key) != count || multiset.contains(key) != (count > 0) || copies != count
+					|| (stored_key == nullptr) != (count == 0) || (stored_key != nullptr && *stored_key != key))
+				{
+					return false;
+				}
+				break;
+			}
+		}
+
+		if (multiset.getSize() != expected.size() || multiset.empty() != expected.empty())
+		{
+			return false;
+		}
+
+		if (i % n == 0)
+		{
+			auto it = expected.begin();
+			unsigned num_distinct = 0;
+			bool matches = true;
+			multiset.forEachInRange(0u, n, [&](const unsigned& visited_key, uint64_t visited_count)
+			{
+				uint64_t count = it != expected.end() && *it == visited_key ? expected.count(visited_key) : 0;
+				matches = matches && count == visited_count;
+				std::advance(it, count);
+				++num_distinct;
+			});
+
+			if (!matches || it != expected.end() || multiset.getDistinctSize() != num_distinct)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Checks a StringZipTree against a std::set<std::string> with random inserts,
+ * removes and lookups of about n distinct keys. Keys mix embedded NULs with
+ * prefixes of each other, and their common prefixes get shorter over time,
+ * so the shared prefix keeps shrinking, and the tree is emptied halfway so it
+ * starts over with a new one. The keys are walked in order and compared
+ * every n operations.
+ *
+ * @return true if the check passed
+ */
+bool run_string_check(unsigned n)
+{
+	static const std::string PREFIXES[] = {"https://example.com/a/", "https://example.com/", "https://ex", "http", ""};
+	static constexpr unsigned NUM_PREFIXES = sizeof(PREFIXES) / sizeof(PREFIXES[0]);
+
+	StringZipTree tree(n);
+	std::set<std::string> expected;
+	std::vector<std::string> seen;
+	std::mt19937 generator(12345);
+
+	// about n distinct keys of up to 8 characters after their prefix
+	unsigned num_characters = 1;
+	while (std::pow(3, num_characters) * NUM_PREFIXES < n && num_characters < 8)
+	{
+		++num_characters;
+	}
+
+	unsigned num_operations = 8 * n;
+	for (unsigned i = 0; i < num_operations; ++i)
+	{
+		if (i == num_operations / 2)
+		{
+			for (const std::string& key : expected)
+			{
+				if (!tree.remove(key))
+				{
+					return false;
+				}
+			}
+
+			expected.clear();
+			if (!tree.empty())
+			{
+				return false;
+			}
+		}
+
+		// later operations may use shorter prefixes
+		std::string key;
+		if (!seen.empty() && generator() % 2 == 0)
+		{
+			key = seen[generator() % seen.size()];
+		}
+		else
+		{
+			unsigned num_allowed = 1 + (NUM_PREFIXES - 1) * (i % (num_operations / 2)) / (num_operations / 2);
+			key = PREFIXES[generator() % num_allowed];
+			for (unsigned length = generator() % (num_characters + 1); length > 0; --length)
+			{
+				key += "\0ab"[generator() % 3];
+			}
+			seen.push_back(key);
+		}
+
+		switch (generator() % 3)
+		{
+			case 0:
+			{
+				if (tree.insert(key) != expected.insert(key).second)
+				{
+					return false;
+				}
+				break;
+			}
+			case 1:
+			{
+				if (tree.remove(key) != (expected.erase(key) == 1))
+				{
+					return false;
+				}
+				break;
+			}
+			default:
+			{
+				std::string high = key + std::string(generator() % 3, 'b');
+				size_t count = std::distance(expected.lower_bound(key), expected.upper_bound(high));
+				if (tree.find(key) != (expected.count(key) == 1) || tree.countRange(key, high) != count)
+				{
+					return false;
+				}
+				break;
+			}
+		}
+
+		if (tree.getSize() != expected.size())
+		{
+			return false;
+		}
+
+		if (i % n == 0)
+		{
+			std::vector<std::string> keys;
+			tree.forEachInRange("", "\xff", [&keys](std::string_view visited) { keys.emplace_back(visited); });
+			if (!std::equal(keys.begin(), keys.end(), expected.begin(), expected.end()))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 int main(int argc, char *argv[])
 {
 	// ZipTree<unsigned> tree(5);
@@ -317,22 +922,152 @@ int main(int argc, char *argv[])
 
 	// get args: computer name, n, num trials, and p (double)
 	std::string computer_name = std::string(argv[1]);
-	unsigned n = std::stoi(std::string(argv[2]));
+	uint64_t simulated_n = std::stoull(std::string(argv[2]));
+	unsigned n = simulated_n;
 	unsigned num_trials = std::stoi(std::string(argv[3]));
 	double p = std::stod(std::string(argv[4]));
 
-	for (p = 0.00001; p < 0.0010000001; p += 0.00001)
+	// only the simulated modes go beyond the 32-bit sizes of real trees
+	std::string mode = argc > 5 ? std::string(argv[5]) : "";
+	if (mode != "simulate" && mode != "sweep" && simulated_n > std::numeric_limits<unsigned>::max())
+	{
+		std::cerr << "n = " << simulated_n << " is too large to build a tree; use simulate or sweep" << std::endl;
+		return 1;
+	}
+
+	// a fifth argument of "simulate" measures shapes without building trees,
+	// for n beyond what fits in memory
+	if (argc > 5 && std::string(argv[5]) == "simulate")
 	{
 		auto start = std::chrono::high_resolution_clock::now();
 		for (unsigned i = 0; i < num_trials; ++i)
 		{
+			run_simulated_experiments(simulated_n, p);
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << computer_name << ": simulated n = " << simulated_n << " took " << (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0) << " seconds" << std::endl;
+		return 0;
+	}
+
+	// a fifth argument of "snapshot" checks finger inserts into a tree loaded
+	// from a snapshot of n keys
+	if (argc > 5 && std::string(argv[5]) == "snapshot")
+	{
+		bool passed = run_snapshot_regression(n, p);
+		std::cout << computer_name << ": snapshot regression " << (passed ? "passed" : "failed") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// a fifth argument of "recovery" checks that a DurableZipTree recovers
+	// after its process exits without closing it
+	if (argc > 5 && std::string(argv[5]) == "recovery")
+	{
+		bool passed = run_recovery_check(n, p);
+		std::cout << computer_name << ": recovery check " << (passed ? "passed" : "failed") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// a fifth argument of "window" checks a sliding window of up to n / 2 keys
+	// against a std::deque
+	if (argc > 5 && std::string(argv[5]) == "window")
+	{
+		bool passed = run_window_check(n, p);
+		std::cout << computer_name << ": window check " << (passed ? "passed" : "failed") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// a fifth argument of "map" checks a ZipTreeMap of keys below n against a
+	// std::map
+	if (argc > 5 && std::string(argv[5]) == "map")
+	{
+		bool passed = run_map_check(n);
+		std::cout << computer_name << ": map check " << (passed ? "passed" : "failed") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// a fifth argument of "multiset" checks a ZipTreeMultiset of keys below n
+	// against a std::multiset
+	if (argc > 5 && std::string(argv[5]) == "multiset")
+	{
+		bool passed = run_multiset_check(n);
+		std::cout << computer_name << ": multiset check " << (passed ? "passed" : "failed") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// a fifth argument of "string" checks a StringZipTree of about n keys
+	// against a std::set<std::string>
+	if (argc > 5 && std::string(argv[5]) == "string")
+	{
+		bool passed = run_string_check(n);
+		std::cout << computer_name << ": string check " << (passed ? "passed" : "failed") << std::endl;
+		return passed ? 0 : 1;
+	}
+
+	// a fifth argument of "sweep" simulates every p of a grid in parallel and
+	// summarizes each p: sweep [linear|log] [low] [high] [points] [rounds],
+	// where each round of refinement adds up to points / 4 p values
+	if (argc > 5 && std::string(argv[5]) == "sweep")
+	{
+		bool is_log = argc > 6 && std::string(argv[6]) == "log";
+		double low = argc > 7 ? std::stod(std::string(argv[7])) : 0.00001;
+		double high = argc > 8 ? std::stod(std::string(argv[8])) : 0.001;
+		unsigned num_points = argc > 9 ? std::stoi(std::string(argv[9])) : 100;
+		unsigned num_rounds = argc > 10 ? std::stoi(std::string(argv[10])) : 0;
+
+		PSweepOptions options;
+		options.n = simulated_n;
+		options.numTrials = num_trials;
+		options.summaryPath = DATA_FILE_DIRECTORY + "variable-p/" + P_SWEEP_FILE_NAME + computer_name + ".csv";
+		PSweep sweep(options);
+
+		std::vector<double> ps = is_log ? make_log_grid(low, high, num_points) : make_linear_grid(low, high, num_points);
+		for (unsigned round = 0; round <= num_rounds && !ps.empty(); ++round)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			sweep.run(ps);
+			auto end = std::chrono::high_resolution_clock::now();
+			std::cout << computer_name << ": swept " << ps.size() << " p values took " << (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0) << " seconds" << std::endl;
+
+			ps = sweep.refine(std::max(num_points / 4, 1u));
+		}
+
+		sweep.flush();
+		return 0;
+	}
+
+	// trials are counted in sweep order, and each one's row is appended before
+	// the count is saved, so a kill repeats at most the trial it interrupted
+	std::string progress_path = DATA_FILE_DIRECTORY + "variable-p/" + SWEEP_PROGRESS_FILE_NAME + computer_name + ".txt";
+	unsigned num_resumed = load_sweep_progress(progress_path, n, num_trials);
+	unsigned completed = 0;
+
+	if (num_resumed > 0)
+	{
+		std::cout << computer_name << ": resuming after " << num_resumed << " finished trials" << std::endl;
+	}
+
+	for (p = 0.00001; p < 0.0010000001; p += 0.00001)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned i = 0; i < num_trials; ++i, ++completed)
+		{
+			if (completed < num_resumed)
+			{
+				continue;
+			}
+
 			run_variable_p_experiment(computer_name, n, p);
+			save_sweep_progress(progress_path, n, num_trials, completed + 1);
 		}
 
 		auto end = std::chrono::high_resolution_clock::now();
 		std::cout << computer_name << ": p = " << p << " took " << (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0) << " seconds" << std::endl;
 	}
 
+	// a finished sweep starts over on the next run
+	std::filesystem::remove(progress_path);
+
 	// for (p = 0.9; p < 0.999999; p += 0.001)
 	// {
 	// 	auto start = std::chrono::high_resolution_clock::now();